@@ -9,8 +9,8 @@
  * on the device and project needs.
  * 
  * In order to use this library please set the chip select, reset, etc.
- * pin definitions in the header file. 
- * Set the SPIBUF and SPIIDLE definitions in the header file to be your
+ * pin definitions in ST7735_config.h.
+ * Set the SPIBUF and SPIIDLE definitions in ST7735_config.h to be your
  * micro's SPI TX buffer, and !(SPIBUSY) flags respectively.
  * Also please write your own SPI
  * initialisation function because it differs from device to device.
@@ -34,7 +34,178 @@
 #include <xc.h>
 #include "ST7735.h"
 
+#if USE_TEXT
+/* Font files. Thanks Adafruit!
+ * Declared const so the compiler keeps them in program memory.
+ */
+const char Font1[] = {
+0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x5F, 0x00, 0x00,
+0x00, 0x07, 0x00, 0x07, 0x00,
+0x14, 0x7F, 0x14, 0x7F, 0x14,
+0x24, 0x2A, 0x7F, 0x2A, 0x12,
+0x23, 0x13, 0x08, 0x64, 0x62,
+0x36, 0x49, 0x56, 0x20, 0x50,
+0x00, 0x08, 0x07, 0x03, 0x00,
+0x00, 0x1C, 0x22, 0x41, 0x00,
+0x00, 0x41, 0x22, 0x1C, 0x00,
+0x2A, 0x1C, 0x7F, 0x1C, 0x2A,
+0x08, 0x08, 0x3E, 0x08, 0x08,
+0x00, 0x80, 0x70, 0x30, 0x00,
+0x08, 0x08, 0x08, 0x08, 0x08,
+0x00, 0x00, 0x60, 0x60, 0x00,
+0x20, 0x10, 0x08, 0x04, 0x02,
+0x3E, 0x51, 0x49, 0x45, 0x3E,
+0x00, 0x42, 0x7F, 0x40, 0x00,
+0x72, 0x49, 0x49, 0x49, 0x46,
+0x21, 0x41, 0x49, 0x4D, 0x33,
+0x18, 0x14, 0x12, 0x7F, 0x10,
+0x27, 0x45, 0x45, 0x45, 0x39,
+0x3C, 0x4A, 0x49, 0x49, 0x31,
+0x41, 0x21, 0x11, 0x09, 0x07,
+0x36, 0x49, 0x49, 0x49, 0x36,
+0x46, 0x49, 0x49, 0x29, 0x1E,
+0x00, 0x00, 0x14, 0x00, 0x00,
+0x00, 0x40, 0x34, 0x00, 0x00,
+0x00, 0x08, 0x14, 0x22, 0x41,
+0x14, 0x14, 0x14, 0x14, 0x14,
+0x00, 0x41, 0x22, 0x14, 0x08,
+0x02, 0x01, 0x59, 0x09, 0x06,
+0x3E, 0x41, 0x5D, 0x59, 0x4E,
+0x7C, 0x12, 0x11, 0x12, 0x7C,
+0x7F, 0x49, 0x49, 0x49, 0x36,
+0x3E, 0x41, 0x41, 0x41, 0x22,
+0x7F, 0x41, 0x41, 0x41, 0x3E,
+0x7F, 0x49, 0x49, 0x49, 0x41,
+0x7F, 0x09, 0x09, 0x09, 0x01,
+0x3E, 0x41, 0x41, 0x51, 0x73,
+0x7F, 0x08, 0x08, 0x08, 0x7F,
+0x00, 0x41, 0x7F, 0x41, 0x00,
+0x20, 0x40, 0x41, 0x3F, 0x01,
+0x7F, 0x08, 0x14, 0x22, 0x41,
+0x7F, 0x40, 0x40, 0x40, 0x40,
+0x7F, 0x02, 0x1C, 0x02, 0x7F,
+0x7F, 0x04, 0x08, 0x10, 0x7F,
+0x3E, 0x41, 0x41, 0x41, 0x3E,
+0x7F, 0x09, 0x09, 0x09, 0x06,
+0x3E, 0x41, 0x51, 0x21, 0x5E,
+0x7F, 0x09, 0x19, 0x29, 0x46
+};
+const char Font2[] = {
+0x26, 0x49, 0x49, 0x49, 0x32,
+0x03, 0x01, 0x7F, 0x01, 0x03,
+0x3F, 0x40, 0x40, 0x40, 0x3F,
+0x1F, 0x20, 0x40, 0x20, 0x1F,
+0x3F, 0x40, 0x38, 0x40, 0x3F,
+0x63, 0x14, 0x08, 0x14, 0x63,
+0x03, 0x04, 0x78, 0x04, 0x03,
+0x61, 0x59, 0x49, 0x4D, 0x43,
+0x00, 0x7F, 0x41, 0x41, 0x41,
+0x02, 0x04, 0x08, 0x10, 0x20,
+0x00, 0x41, 0x41, 0x41, 0x7F,
+0x04, 0x02, 0x01, 0x02, 0x04,
+0x40, 0x40, 0x40, 0x40, 0x40,
+0x00, 0x03, 0x07, 0x08, 0x00,
+0x20, 0x54, 0x54, 0x78, 0x40,
+0x7F, 0x28, 0x44, 0x44, 0x38,
+0x38, 0x44, 0x44, 0x44, 0x28,
+0x38, 0x44, 0x44, 0x28, 0x7F,
+0x38, 0x54, 0x54, 0x54, 0x18,
+0x00, 0x08, 0x7E, 0x09, 0x02,
+0x18, 0xA4, 0xA4, 0x9C, 0x78,
+0x7F, 0x08, 0x04, 0x04, 0x78,
+0x00, 0x44, 0x7D, 0x40, 0x00,
+0x20, 0x40, 0x40, 0x3D, 0x00,
+0x7F, 0x10, 0x28, 0x44, 0x00,
+0x00, 0x41, 0x7F, 0x40, 0x00,
+0x7C, 0x04, 0x78, 0x04, 0x78,
+0x7C, 0x08, 0x04, 0x04, 0x78,
+0x38, 0x44, 0x44, 0x44, 0x38,
+0xFC, 0x18, 0x24, 0x24, 0x18,
+0x18, 0x24, 0x24, 0x18, 0xFC,
+0x7C, 0x08, 0x04, 0x04, 0x08,
+0x48, 0x54, 0x54, 0x54, 0x24,
+0x04, 0x04, 0x3F, 0x44, 0x24,
+0x3C, 0x40, 0x40, 0x20, 0x7C,
+0x1C, 0x20, 0x40, 0x20, 0x1C,
+0x3C, 0x40, 0x30, 0x40, 0x3C,
+0x44, 0x28, 0x10, 0x28, 0x44,
+0x4C, 0x90, 0x90, 0x90, 0x7C,
+0x44, 0x64, 0x54, 0x4C, 0x44,
+0x00, 0x08, 0x36, 0x41, 0x00,
+0x00, 0x00, 0x77, 0x00, 0x00,
+0x00, 0x41, 0x36, 0x08, 0x00,
+0x24, 0x66, 0xE7, 0x66, 0x24
+};
+#endif
+
+#if USE_EXAMPLE_BITMAPS
+//Some bitmaps (see bitmap function for description)
+//First to integers are width, height respectively.
+const unsigned int testBMP[] = {8, 8,
+    0xAAAA, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x5555,
+    0x0000, 0xAAAA, 0x000F, 0x00F0, 0x0F00, 0xF000, 0x5555, 0x0000,
+    0x0000, 0x0000, 0x00FF, 0x0FF0, 0xFF00, 0xF00F, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0FFF, 0xFFF0, 0xFF0F, 0xF0FF, 0x0000, 0x0000,
+    0x0000, 0x0000, 0xF0F0, 0x0F0F, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
+    0x0000, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
+    0x0000, 0x5555, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xAAAA, 0x0000,
+    0x5555, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0xAAAA
+};
+
+const unsigned int downArrowBMP[] = {8, 4,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000,
+    0x0000, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0xFFFF, 0xFFFF, 0x0000, 0x0000, 0x0000
+};
+#endif
 
+#if USE_BUS_STATS
+lcd_stats_t lcd_stats;
+
+/*
+ * Clears the bus statistics, call before the workload you want to measure.
+ */
+void lcd_stats_reset(void) {
+    lcd_stats.bytes = 0;
+    lcd_stats.selects = 0;
+    lcd_stats.windows = 0;
+#if USE_POWER
+    lcd_stats.ms = 0;
+    lcd_stats.sleep_ms = 0;
+    lcd_stats.partial_ms = 0;
+    lcd_stats.idle_ms = 0;
+#endif
+}
+
+/*
+ * Rough time the counted traffic would take on the bus, in microseconds,
+ * at an SPI clock of spi_khz. Only counts the clock cycles (8 per byte),
+ * so the real time will be a bit longer depending on the micro.
+ * (Good for up to about 500k bytes before the sum overflows.)
+ */
+unsigned long lcd_stats_estimate_us(unsigned long spi_khz) {
+    return (lcd_stats.bytes * 8000) / spi_khz;
+}
+
+#if USE_POWER
+/*
+ * Adds ms milliseconds to the time spent in the current power mode.
+ * Call it from your timer tick. Partial and idle can both be counted
+ * for the same tick, time in normal mode is ms minus the others.
+ */
+void lcd_stats_tick(unsigned int ms) {
+    lcd_stats.ms += ms;
+    if(lcd_mode & LCD_MODE_SLEEP)
+        lcd_stats.sleep_ms += ms;
+    if(lcd_mode & LCD_MODE_PARTIAL)
+        lcd_stats.partial_ms += ms;
+    if(lcd_mode & LCD_MODE_IDLE)
+        lcd_stats.idle_ms += ms;
+}
+#endif
+#endif
 
 /*
  * Writes a byte to SPI without changing chip select (CSX) state.
@@ -43,36 +214,57 @@
  * 
  * This will use either a software implementation or the hardware
  * implementation depending on if USE_HW_SPI flag is set in the 
- * header file. (Software SPI is reeeeeally slow. Measured at 
+ * config file. (Software SPI is reeeeeally slow. Measured at 
  * 40 kHz clock compared to 2 MHz clock with hardware SPI).
  */
 void spi_write(unsigned char data) {
-    if(USE_HW_SPI) {
-        //Use the on-bard hardware SPI registers
-        //TODO: Update these buffer labels according to your device.
-        
-        //Write data to SSPBUFF
-        SPIBUF = data;
-        //Wait for transmission to finish
-        while(!(SPIIDLE));
-    } else {
-        //Otherwise just bit bang this through
-        for(int i = 7; i >= 0; i--) {
-            //asm("NOP"); //May or may not be needed for timing
-            SCK = 0;
-            SDO = (data >> i) & 0x01;
-            //asm("NOP");
-            SCK = 1; //Data sampled on rising clock edge.
-        }
+    LCD_STAT(bytes);
+#if USE_HW_SPI
+    //Use the on-bard hardware SPI registers
+    //TODO: Update these buffer labels according to your device.
+
+    //Write data to SSPBUFF
+    SPIBUF = data;
+    //Wait for transmission to finish
+    while(!(SPIIDLE));
+#else
+    //Otherwise just bit bang this through
+    for(int i = 7; i >= 0; i--) {
+        //asm("NOP"); //May or may not be needed for timing
+        SCK = 0;
+        SDO = (data >> i) & 0x01;
+        //asm("NOP");
+        SCK = 1; //Data sampled on rising clock edge.
     }
+#endif
 }
 
+#if USE_READBACK
+/*
+ * Reads a byte from the display over the shared SDA line, always bit
+ * banged because the line has to be turned around to an input (see
+ * lcd_read_begin()). The display changes the data on the falling clock
+ * edge, so we sample after the rising edge.
+ */
+unsigned char spi_read(void) {
+    unsigned char data = 0;
+    LCD_STAT(bytes);
+    for(char i = 0; i < 8; i++) {
+        SCK = 0;
+        SCK = 1;
+        data = (data << 1) | (SDA_IN & 0x01);
+    }
+    return data;
+}
+#endif
+
 /*
  * Writes a data byte to the display. Pulls CS low as required.
  */
 void lcd_write_data(unsigned char data) {
     //CS LOW
     CSX = 0;
+    LCD_STAT(selects);
     //Send data to the SPI register
     spi_write(data);
     //CS HIGH
@@ -86,6 +278,7 @@ void lcd_write_command(unsigned char data) {
     //Pull the command AND chip select lines LOW
     CMD = 0;
     CSX = 0;
+    LCD_STAT(selects);
     spi_write(data);
     //Return the control lines to HIGH
     CMD = 1;
@@ -145,19 +338,146 @@ void lcd_init_command_list(void)
     
     lcd_write_command(ST7735_SWRESET);
     delay_ms(100);
-    lcd_write_command(0x11);//Sleep out
+    lcd_write_command(ST7735_SLPOUT);//Sleep out
     delay_ms(120);
     //------//
 
     //Add any custom settings to the command list here
     
     //------//
-    lcd_write_command(0x3A);
+#if USE_POWER
+    //Start every mode from a known frame rate, lcd_full_power() puts
+    //these back after a low power profile has changed them
+    lcd_frame_rate(ST7735_FRMCTR1, FRAME_RTNA, FRAME_FPA, FRAME_BPA);
+    lcd_frame_rate(ST7735_FRMCTR2, FRAME_RTNA, FRAME_FPA, FRAME_BPA);
+    lcd_frame_rate(ST7735_FRMCTR3, FRAME_RTNA, FRAME_FPA, FRAME_BPA);
+#endif
+    lcd_write_command(ST7735_COLMOD);
     lcd_write_data(0x05);
     
-    lcd_write_command(0x29);//Display on
+    lcd_write_command(ST7735_DISPON);//Display on
+#if USE_POWER
+    lcd_mode = 0;
+#endif
+}
+
+#if USE_POWER
+unsigned char lcd_mode;
+
+/*
+ * Puts the panel to sleep. The display goes blank but GRAM is kept, so
+ * nothing needs redrawing after lcd_wake().
+ * NOTE: the datasheet wants 120ms between sleep in and sleep out, so
+ * don't call lcd_wake() straight away.
+ */
+void lcd_sleep(void) {
+    lcd_write_command(ST7735_SLPIN);
+    //5ms before the next command
+    delay_ms(5);
+    lcd_mode |= LCD_MODE_SLEEP;
+}
+
+/*
+ * Wakes the panel up again. Takes 120ms for the supplies to settle
+ * before it will take any more commands.
+ */
+void lcd_wake(void) {
+    lcd_write_command(ST7735_SLPOUT);
+    delay_ms(120);
+    lcd_mode &= ~LCD_MODE_SLEEP;
+}
+
+/*
+ * Only refresh rows start_row to end_row (inclusive). The rest of the
+ * panel shows the non-display colour (black on most modules).
+ * Drawing outside the partial area still goes in to GRAM, it just won't
+ * show until lcd_normal() is called.
+ */
+void lcd_partial(char start_row, char end_row) {
+    lcd_write_command(ST7735_PTLAR);
+    lcd_write_data(0x00);
+    lcd_write_data(start_row);
+    lcd_write_data(0x00);
+    lcd_write_data(end_row);
+    
+    lcd_write_command(ST7735_PTLON);
+    lcd_mode |= LCD_MODE_PARTIAL;
+}
+
+/*
+ * Back to refreshing the whole panel.
+ */
+void lcd_normal(void) {
+    lcd_write_command(ST7735_NORON);
+    lcd_mode &= ~LCD_MODE_PARTIAL;
+}
+
+/*
+ * Idle mode only shows the top bit of each colour (8 colours), which
+ * saves a fair bit of panel current. GRAM is untouched.
+ */
+void lcd_idle(char on) {
+    if(on) {
+        lcd_write_command(ST7735_IDMON);
+        lcd_mode |= LCD_MODE_IDLE;
+    } else {
+        lcd_write_command(ST7735_IDMOFF);
+        lcd_mode &= ~LCD_MODE_IDLE;
+    }
 }
 
+/*
+ * Sets the frame rate for one mode. reg is ST7735_FRMCTR1 (normal),
+ * ST7735_FRMCTR2 (idle) or ST7735_FRMCTR3 (partial).
+ * On the ST7735 the frame rate is 333kHz / ((rtna * 2 + 40) * (rows + fpa + bpa))
+ * (the R and S versions differ slightly, check your datasheet), so bigger
+ * numbers give a slower refresh and a lower current. rtna is 4 bits, fpa
+ * and bpa are 6 bits. lcd_init() sets all three modes to the FRAME_RTNA,
+ * FRAME_FPA and FRAME_BPA values in ST7735_config.h.
+ */
+void lcd_frame_rate(unsigned char reg, unsigned char rtna, unsigned char fpa, unsigned char bpa) {
+    lcd_write_command(reg);
+    lcd_write_data(rtna);
+    lcd_write_data(fpa);
+    lcd_write_data(bpa);
+    //Partial mode has separate settings for dot and column inversion
+    if(reg == ST7735_FRMCTR3) {
+        lcd_write_data(rtna);
+        lcd_write_data(fpa);
+        lcd_write_data(bpa);
+    }
+}
+
+/*
+ * Low power profile for showing a small status band, e.g. a clock or a
+ * battery level. Only rows start_row to end_row are refreshed, in 8
+ * colours, at the slowest frame rate. Keep drawing to the band as normal
+ * and call lcd_full_power() to get the whole display back.
+ */
+void lcd_status_strip(char start_row, char end_row) {
+    lcd_frame_rate(ST7735_FRMCTR2, 0x0F, 0x3F, 0x3F);
+    lcd_frame_rate(ST7735_FRMCTR3, 0x0F, 0x3F, 0x3F);
+    lcd_partial(start_row, end_row);
+    lcd_idle(1);
+}
+
+/*
+ * Undoes lcd_status_strip() (or any of the other power modes) and puts
+ * the idle and partial frame rates back to the ones lcd_init() set.
+ * NOTE: if the panel is asleep this wakes it, so the same 120ms rule as
+ * lcd_wake() applies: don't call it within 120ms of lcd_sleep().
+ */
+void lcd_full_power(void) {
+    //Must be at least 120ms since lcd_sleep(), see above
+    if(lcd_mode & LCD_MODE_SLEEP)
+        lcd_wake();
+    lcd_idle(0);
+    lcd_normal();
+    lcd_frame_rate(ST7735_FRMCTR2, FRAME_RTNA, FRAME_FPA, FRAME_BPA);
+    lcd_frame_rate(ST7735_FRMCTR3, FRAME_RTNA, FRAME_FPA, FRAME_BPA);
+}
+#endif
+
 /*
  * Draws a single pixel to the LCD at position X, Y, with 
  * Colour.
@@ -185,6 +505,7 @@ void fill_rectangle(char x1, char y1, char x2, char y2, unsigned int colour) {
     // data sections but I don't trust it.)
     //CSX low to begin data
     CSX = 0;
+    LCD_STAT(selects);
     //Write colour to each pixel
     for(int y = 0; y < y2-y1+1 ; y++) {
         for(int x = 0; x < x2-x1+1; x++) {
@@ -202,6 +523,18 @@ void fill_rectangle(char x1, char y1, char x2, char y2, unsigned int colour) {
  * to the display.
  */
 void set_draw_window(char x1, char y1, char x2, char y2) {
+    set_window_area(x1, y1, x2, y2);
+    
+    //Write to RAM
+    lcd_write_command(ST7735_RAMWR);
+}
+
+/*
+ * Sets the column and row range used by the next RAMWR or RAMRD without
+ * starting either of them.
+ */
+void set_window_area(char x1, char y1, char x2, char y2) {
+    LCD_STAT(windows);
     //SEt the column to write to
     lcd_write_command(ST7735_CASET);
     lcd_write_data(0x00);
@@ -215,9 +548,181 @@ void set_draw_window(char x1, char y1, char x2, char y2) {
     lcd_write_data(y1);
     lcd_write_data(0x00);
     lcd_write_data(y2);
+}
+
+#if USE_FILLS
+//4x4 ordered dither thresholds (Bayer matrix), 0-15
+const unsigned char dither_table[16] = {
+    0, 8, 2, 10,
+    12, 4, 14, 6,
+    3, 11, 1, 9,
+    15, 7, 13, 5
+};
+
+/*
+ * One colour channel of a gradient. It is stepped Bresenham style: a
+ * whole part every pixel, plus a remainder that is carried until it adds
+ * up to one more, so the last pixel lands exactly on the end colour.
+ */
+typedef struct {
+    unsigned char value;
+    unsigned char whole;    //Whole amount added every step
+    unsigned char part;     //Remainder added to carry every step
+    int carry;
+    char down;              //Channel gets smaller
+} gradient_channel_t;
+
+void gradient_channel_init(gradient_channel_t *ch, int from, int to, int steps) {
+    int delta = to - from;
     
-    //Write to RAM
-    lcd_write_command(ST7735_RAMWR);
+    ch->value = from;
+    ch->down = delta < 0;
+    if(delta < 0)
+        delta = -delta;
+    ch->whole = delta / steps;
+    ch->part = delta % steps;
+    //Start half way so the channel rounds instead of truncating
+    ch->carry = steps / 2;
+}
+
+void gradient_channel_step(gradient_channel_t *ch, int steps) {
+    unsigned char step = ch->whole;
+    
+    ch->carry += ch->part;
+    if(ch->carry >= steps) {
+        ch->carry -= steps;
+        step++;
+    }
+    if(ch->down)
+        ch->value -= step;
+    else
+        ch->value += step;
+}
+
+/*
+ * Fills a rectangle with a smooth blend from colour_a to colour_b, left to
+ * right, or top to bottom if vertical is set. The first pixel is exactly
+ * colour_a and the last is exactly colour_b.
+ * Each colour channel is stepped along without any divides in the loop,
+ * so the whole thing is streamed in to one draw window just like
+ * fill_rectangle().
+ */
+void fill_gradient(char x1, char y1, char x2, char y2, unsigned int colour_a, unsigned int colour_b, char vertical) {
+    gradient_channel_t r_start, g_start, b_start;
+    gradient_channel_t r, g, b;
+    int steps = vertical ? y2 - y1 : x2 - x1;
+    unsigned int colour;
+    
+    //A single pixel wide gradient is just colour_a
+    if(steps < 1)
+        steps = 1;
+    
+    //Split both colours in to their 5-6-5 channels
+    gradient_channel_init(&r_start, colour_a >> 11, colour_b >> 11, steps);
+    gradient_channel_init(&g_start, (colour_a >> 5) & 0x3F, (colour_b >> 5) & 0x3F, steps);
+    gradient_channel_init(&b_start, colour_a & 0x1F, colour_b & 0x1F, steps);
+    r = r_start;
+    g = g_start;
+    b = b_start;
+    
+    set_draw_window(x1, y1, x2, y2);
+    
+    CSX = 0;
+    LCD_STAT(selects);
+    for(int y = 0; y < y2-y1+1; y++) {
+        //Horizontal gradients start again at colour_a on every row
+        if(!vertical) {
+            r = r_start;
+            g = g_start;
+            b = b_start;
+        }
+        for(int x = 0; x < x2-x1+1; x++) {
+            colour = ((unsigned int)r.value << 11) | ((unsigned int)g.value << 5) | b.value;
+            spi_write(colour >> 8);
+            spi_write(colour & 0xFF);
+            if(!vertical) {
+                gradient_channel_step(&r, steps);
+                gradient_channel_step(&g, steps);
+                gradient_channel_step(&b, steps);
+            }
+        }
+        if(vertical) {
+            gradient_channel_step(&r, steps);
+            gradient_channel_step(&g, steps);
+            gradient_channel_step(&b, steps);
+        }
+    }
+    CSX = 1;
+}
+
+/*
+ * Fills a rectangle with an ordered dither of two colours. level is how
+ * much of colour_b to use, from 0 (all colour_a) to 16 (all colour_b).
+ * Good for shading and "half tone" effects, and it still looks right in
+ * idle (8 colour) mode. The pattern is lined up with the screen, so fills
+ * next to each other, or a redraw of part of one, join without a seam.
+ */
+void fill_dither(char x1, char y1, char x2, char y2, unsigned int colour_a, unsigned int colour_b, unsigned char level) {
+    set_draw_window(x1, y1, x2, y2);
+    
+    CSX = 0;
+    LCD_STAT(selects);
+    for(int y = 0; y < y2-y1+1; y++) {
+        //Use screen coordinates so neighbouring fills line up
+        const unsigned char *row = &dither_table[((y1 + y) & 0x03) << 2];
+        for(int x = 0; x < x2-x1+1; x++) {
+            unsigned int colour = row[(x1 + x) & 0x03] < level ? colour_b : colour_a;
+            spi_write(colour >> 8);
+            spi_write(colour & 0xFF);
+        }
+    }
+    CSX = 1;
+}
+
+/*
+ * Fills a rectangle by repeating a small tile over it. The tile is in the
+ * same format as draw_bitmap(): width, height, then the pixel colours.
+ * The tile is lined up with the top left corner of the screen, so fills
+ * next to each other, or redrawing part of one, don't leave a seam.
+ */
+void fill_pattern(char x1, char y1, char x2, char y2, const unsigned int *tile) {
+    int width = tile[0];
+    int height = tile[1];
+    int start_x = x1 % width;
+    int tile_y = y1 % height;
+    
+    set_draw_window(x1, y1, x2, y2);
+    
+    CSX = 0;
+    LCD_STAT(selects);
+    for(int y = 0; y < y2-y1+1; y++) {
+        const unsigned int *row = &tile[(width * tile_y) + 2];
+        int tile_x = start_x;
+        for(int x = 0; x < x2-x1+1; x++) {
+            spi_write(row[tile_x] >> 8);
+            spi_write(row[tile_x] & 0xFF);
+            //Step along the tile without needing a divide
+            if(++tile_x == width)
+                tile_x = 0;
+        }
+        if(++tile_y == height)
+            tile_y = 0;
+    }
+    CSX = 1;
+}
+#endif
+
+#if USE_TEXT
+/*
+ * Gets one column (0-4) of a character from the font. Bit 0 is the top
+ * row of the character.
+ */
+char font_column(char c, char i) {
+    //We have to pick from a different font file depending on the character.
+    //See note in Font[] definition. Font2 starts at 'S'.
+    if(c < 'S')
+        return Font1[((c - 32) * 5) + i];
+    return Font2[((c - 'S') * 5) + i];
 }
 
 /*
@@ -227,16 +732,10 @@ void set_draw_window(char x1, char y1, char x2, char y2) {
 void draw_char(char x, char y, char c, unsigned int colour, char size){
     int i, j;
     char line;
-    unsigned int font_index = (c - 32) * 5;
     
     //Get the line of pixels from the font file
     for(i=0; i<5; i++ ) {
-        //We have to pick from a different font file depending on the character.
-        //See note in Font[] definition.
-        if(c < 'T')
-            line = Font1[font_index + i];
-        else
-            line = Font2[((c - 'S') * 5) + i];
+        line = font_column(c, i);
         
         //Draw the pixels to screen
         for(j=0; j<7; j++) {
@@ -272,7 +771,9 @@ void draw_string(char x, char y, unsigned int colour, char size, char *str) {
         counter++;
     }
 }
+#endif
 
+#if USE_BITMAPS
 /* Draws a bitmap array of colours to the display.
  * First two bytes should be width and height respectively.
  * Subsequent bits are uint16 representations of the pixel colours.
@@ -280,7 +781,7 @@ void draw_string(char x, char y, unsigned int colour, char size, char *str) {
  * NOTE: This could be made more efficient by not using the fill_rectangle
  * method. But I didn't need the speed, and it simplified the code a lot.
  */
-void draw_bitmap(int x, int y, int scale, unsigned int *bmp) {
+void draw_bitmap(int x, int y, int scale, const unsigned int *bmp) {
     int width = bmp[0];
     int height = bmp[1];
     unsigned int this_byte;
@@ -306,27 +807,447 @@ void draw_bitmap(int x, int y, int scale, unsigned int *bmp) {
     //Return CSX to high
     //CSX = 1;
 }
+#endif
 
+#if USE_LINES
 /*
  * Draw a line between two points, using the desired colour. Doesn't do any
  * fancy aliasing or anything.
  * 
- * NOTE: Using floats takes up a huge amount of program memory. I would 
- * recommend commenting out this function unless absolutely necessary.
- * Use fill_rectangle() to draw horizontal and vertical lines instead.
+ * Integer Bresenham, so no floats are needed. Pixels that sit next to each
+ * other in the same row (or column for steep lines) are sent as one
+ * fill_rectangle() run, so horizontal and vertical lines only cost a single
+ * draw window.
+ */
+void draw_line(char x1, char y1, char x2, char y2, unsigned int colour) {
+    int ax = x1, ay = y1, bx = x2, by = y2;
+    int t;
+    char steep = 0;
+    
+    //Always walk along the longest axis, swapping x and y for steep lines
+    if((by > ay ? by - ay : ay - by) > (bx > ax ? bx - ax : ax - bx)) {
+        steep = 1;
+        t = ax; ax = ay; ay = t;
+        t = bx; bx = by; by = t;
+    }
+    //And always walk in the positive direction
+    if(ax > bx) {
+        t = ax; ax = bx; bx = t;
+        t = ay; ay = by; by = t;
+    }
+    
+    int dx = bx - ax;
+    int dy = by > ay ? by - ay : ay - by;
+    int step = by > ay ? 1 : -1;
+    int err = dx / 2;
+    int y = ay;
+    int run_start = ax;
+    
+    for(int x = ax; x <= bx; x++) {
+        err -= dy;
+        if(err < 0 || x == bx) {
+            //End of this run, draw it and move on to the next row
+            if(steep)
+                fill_rectangle(y, run_start, y, x, colour);
+            else
+                fill_rectangle(run_start, y, x, y, colour);
+            y += step;
+            err += dx;
+            run_start = x + 1;
+        }
+    }
+}
+#endif
+
+#if USE_ARCS
+/*
+ * Quarter wave sine table, sin(0..89 degrees) scaled by 256.
+ * (Capped at 255 to fit in a byte, sin(90) is handled separately.)
+ */
+const unsigned char sin_table[90] = {
+    0, 4, 9, 13, 18, 22, 27, 31, 36, 40,
+    44, 49, 53, 58, 62, 66, 71, 75, 79, 83,
+    88, 92, 96, 100, 104, 108, 112, 116, 120, 124,
+    128, 132, 136, 139, 143, 147, 150, 154, 158, 161,
+    165, 168, 171, 175, 178, 181, 184, 187, 190, 193,
+    196, 199, 202, 204, 207, 210, 212, 215, 217, 219,
+    222, 224, 226, 228, 230, 232, 234, 236, 237, 239,
+    241, 242, 243, 245, 246, 247, 248, 249, 250, 251,
+    252, 253, 254, 254, 255, 255, 255, 255, 255, 255
+};
+
+/*
+ * Fixed point sine of an angle in whole degrees. The result is scaled by
+ * 256, so multiply by a length and shift right by 8 to get pixels.
+ */
+int sin_fixed(int degrees) {
+    char negative = 0;
+    int value;
+    
+    while(degrees < 0)
+        degrees += 360;
+    while(degrees >= 360)
+        degrees -= 360;
+    
+    //Fold everything back in to the first quadrant
+    if(degrees >= 180) {
+        degrees -= 180;
+        negative = 1;
+    }
+    if(degrees > 90)
+        degrees = 180 - degrees;
+    
+    if(degrees == 90)
+        value = 256;
+    else
+        value = sin_table[degrees];
+    
+    return negative ? -value : value;
+}
+
+/*
+ * Fixed point cosine, scaled by 256 (see sin_fixed()).
+ */
+int cos_fixed(int degrees) {
+    return sin_fixed(degrees + 90);
+}
+
+//Edges of the arc being filled, set up by fill_arc()
+int arc_start_x, arc_start_y, arc_end_x, arc_end_y;
+char arc_wide; //Arc is more than half a circle
+char arc_full; //Arc is the whole circle
+
+/*
+ * Checks if the point dx, dy (relative to the centre) is inside the arc,
+ * using cross products with the start and end edges.
+ */
+char arc_contains(int dx, int dy) {
+    if(arc_full)
+        return 1;
+    
+    char after_start = (long)arc_start_x * dy - (long)arc_start_y * dx >= 0;
+    char before_end = (long)arc_end_x * dy - (long)arc_end_y * dx <= 0;
+    
+    if(arc_wide)
+        return after_start || before_end;
+    return after_start && before_end;
+}
+
+/*
+ * Fills the part of one row between xa and xb (relative to cx) that is
+ * inside the arc, one draw window for each unbroken run of pixels.
+ */
+void arc_row(char cx, char y, int dy, int xa, int xb, unsigned int colour) {
+    int run_start = xa;
+    char in_run = 0;
+    
+    for(int x = xa; x <= xb; x++) {
+        if(arc_contains(x, dy)) {
+            if(!in_run) {
+                run_start = x;
+                in_run = 1;
+            }
+        } else if(in_run) {
+            fill_rectangle(cx + run_start, y, cx + x - 1, y, colour);
+            in_run = 0;
+        }
+    }
+    if(in_run)
+        fill_rectangle(cx + run_start, y, cx + xb, y, colour);
+}
+
+/*
+ * Fills a ring segment centred on cx, cy between the radii r_in and r_out.
+ * Angles are in degrees, clockwise from 3 o'clock, and the arc is filled
+ * clockwise from start to end. Use r_in = 0 for a pie slice, or 0 to 360
+ * for a full ring (see fill_annulus()).
  * 
- * TODO: Also this function doesn't actually work properly.
+ * Each row is worked out incrementally from the last one, so there is no
+ * square root and the ring is drawn as horizontal runs.
+ */
+void fill_arc(char cx, char cy, char r_in, char r_out, int start, int end, unsigned int colour) {
+    //Edges are at r + 1/2 and r_in - 1/2 so the circles don't get
+    //single pixel bumps at the top, bottom and sides
+    int r_out2 = r_out * r_out + r_out;
+    int r_in2 = r_in * r_in - r_in;
+    int x_out = r_out; //Last pixel inside the outer edge
+    int x_in = r_in ? r_in : -1; //Last pixel inside the hole, -1 when no hole
+    
+    arc_full = (end - start) >= 360;
+    arc_wide = (end - start) > 180;
+    arc_start_x = cos_fixed(start);
+    arc_start_y = sin_fixed(start);
+    arc_end_x = cos_fixed(end);
+    arc_end_y = sin_fixed(end);
+    
+    for(int dy = 0; dy <= r_out; dy++) {
+        int dy2 = dy * dy;
+        while(x_out * x_out + dy2 > r_out2)
+            x_out--;
+        while(x_in >= 0 && x_in * x_in + dy2 > r_in2)
+            x_in--;
+        
+        //Bottom half, then the mirrored row in the top half
+        for(char half = 0; half < 2; half++) {
+            int row_dy = half ? -dy : dy;
+            if(half && dy == 0)
+                break;
+            if(x_in < 0) {
+                arc_row(cx, cy + row_dy, row_dy, -x_out, x_out, colour);
+            } else {
+                arc_row(cx, cy + row_dy, row_dy, -x_out, -x_in - 1, colour);
+                arc_row(cx, cy + row_dy, row_dy, x_in + 1, x_out, colour);
+            }
+        }
+    }
+}
+#endif
+
+#if USE_GAUGE
+/*
+ * Works out the needle angle for a value, clamped to the gauge range.
+ */
+int gauge_angle(gauge_t *g, int value) {
+    if(value < g->min)
+        value = g->min;
+    if(value > g->max)
+        value = g->max;
+    return g->start + (int)(((long)(value - g->min) * g->sweep) / (g->max - g->min));
+}
+
+/*
+ * Draws a radial line from r1 to r2 out from the centre of the gauge.
+ */
+void gauge_spoke(gauge_t *g, int angle, char r1, char r2, unsigned int colour) {
+    int c = cos_fixed(angle);
+    int s = sin_fixed(angle);
+    draw_line(g->cx + ((r1 * c) >> 8), g->cy + ((r1 * s) >> 8),
+            g->cx + ((r2 * c) >> 8), g->cy + ((r2 * s) >> 8), colour);
+}
+
+/*
+ * Angle of tick number i (0 is the minimum value, ticks - 1 the maximum).
+ */
+int gauge_tick_angle(gauge_t *g, char i) {
+    return g->start + (int)(((long)g->sweep * i) / (g->ticks - 1));
+}
+
+/*
+ * Draws the whole gauge: the face, the ticks and the needle at value.
+ * Call once, then use gauge_set() to move the needle.
+ */
+void gauge_draw(gauge_t *g, int value) {
+    fill_annulus(g->cx, g->cy, 0, g->radius, g->face_colour);
+    
+    for(char i = 0; i < g->ticks; i++)
+        gauge_spoke(g, gauge_tick_angle(g, i), GAUGE_TICK_IN(g->radius), g->radius - 1, g->tick_colour);
+    
+    g->angle = gauge_angle(g, value);
+    gauge_spoke(g, g->angle, 0, GAUGE_NEEDLE(g->radius), g->needle_colour);
+}
+
+/*
+ * Moves the needle to a new value. Only the old needle is rubbed out and
+ * only the ticks it was lying across are put back, so this is cheap enough
+ * to call every time a new reading comes in.
+ */
+void gauge_set(gauge_t *g, int value) {
+    int angle = gauge_angle(g, value);
+    int tick_in = GAUGE_TICK_IN(g->radius);
+    
+    if(angle == g->angle)
+        return;
+    
+    //Rub out the old needle
+    gauge_spoke(g, g->angle, 0, GAUGE_NEEDLE(g->radius), g->face_colour);
+    
+    //Put back any ticks it was touching. A degree is roughly radius / 57
+    //pixels, so anything within about 2 pixels at the inner tick end is hit.
+    for(char i = 0; i < g->ticks; i++) {
+        int diff = gauge_tick_angle(g, i) - g->angle;
+        if(diff < 0)
+            diff = -diff;
+        if(diff * tick_in < 115)
+            gauge_spoke(g, gauge_tick_angle(g, i), tick_in, g->radius - 1, g->tick_colour);
+    }
+    
+    g->angle = angle;
+    gauge_spoke(g, angle, 0, GAUGE_NEEDLE(g->radius), g->needle_colour);
+}
+#endif
+
+#if USE_READBACK
+/*
+ * Starts reading GRAM from the window x1, y1 to x2, y2. The pixels then
+ * come back in the same order they are written, one lcd_read_pixel()
+ * each. CSX has to stay low for the whole read, so don't draw anything
+ * until lcd_read_end() has been called.
+ */
+void lcd_read_begin(char x1, char y1, char x2, char y2) {
+    set_window_area(x1, y1, x2, y2);
+    
+    //The command and the data that comes back have to be in one CSX frame
+    CMD = 0;
+    CSX = 0;
+    LCD_STAT(selects);
+    spi_write(ST7735_RAMRD);
+    CMD = 1;
+    
+    //Hand the data line over to the display
+    SPI_READ_BEGIN();
+    SDA_TRIS = 1;
+    
+    //Skip the dummy clocks before the first pixel
+    for(char i = 0; i < READ_DUMMY_BITS; i++) {
+        SCK = 0;
+        SCK = 1;
+    }
+}
+
+/*
+ * Reads the next pixel. GRAM is always read back as 18 bit colour
+ * (3 bytes, 6 bits each in the top of the byte), so it is packed back
+ * down to 5-6-5 here.
+ */
+unsigned int lcd_read_pixel(void) {
+    unsigned char r = spi_read();
+    unsigned char g = spi_read();
+    unsigned char b = spi_read();
+    return ((unsigned int)(r & 0xF8) << 8) | ((unsigned int)(g & 0xFC) << 3) | (b >> 3);
+}
+
+/*
+ * Finishes a read and gives the data line back to the micro.
  */
+void lcd_read_end(void) {
+    CSX = 1;
+    SDA_TRIS = 0;
+    SPI_READ_END();
+}
+
 /*
-void draw_line(unsigned char x1, unsigned char y1, unsigned char x2, unsigned char y2, unsigned int colour) {
-    //Calculate the horizontal length of the line
-    int length = x2 - x1;
-    //And calculate the rate of change of the graph
-    float gradient = (y2 - y1) / length;
+ * Reads a rectangle of the display in to buf, row by row. buf needs room
+ * for (x2-x1+1) * (y2-y1+1) colours.
+ */
+void read_rectangle(char x1, char y1, char x2, char y2, unsigned int *buf) {
+    lcd_read_begin(x1, y1, x2, y2);
+    for(int y = 0; y < y2-y1+1; y++) {
+        for(int x = 0; x < x2-x1+1; x++)
+            *buf++ = lcd_read_pixel();
+    }
+    lcd_read_end();
+}
+
+/*
+ * Reads a rectangle of the display and hands each pixel, row by row, to
+ * sink (e.g. a function that sends it out of the UART). Nothing is
+ * buffered, so this can take a screenshot on a micro with no spare RAM.
+ */
+void dump_rectangle(char x1, char y1, char x2, char y2, void (*sink)(unsigned int colour)) {
+    lcd_read_begin(x1, y1, x2, y2);
+    for(int y = 0; y < y2-y1+1; y++) {
+        for(int x = 0; x < x2-x1+1; x++)
+            sink(lcd_read_pixel());
+    }
+    lcd_read_end();
+}
+
+/*
+ * Mixes two colours. alpha is how much of colour_b to use, from 0 (all
+ * colour_a) to 255 (nearly all colour_b).
+ */
+unsigned int blend_colour(unsigned int colour_a, unsigned int colour_b, unsigned char alpha) {
+    int r = colour_a >> 11;
+    int g = (colour_a >> 5) & 0x3F;
+    int b = colour_a & 0x1F;
+    
+    r += (((int)(colour_b >> 11) - r) * alpha) >> 8;
+    g += (((int)((colour_b >> 5) & 0x3F) - g) * alpha) >> 8;
+    b += (((int)(colour_b & 0x1F) - b) * alpha) >> 8;
     
-    //For each horizontal pixel, move down (or up) by the gradient value
-    for(int i = 0; i <= length; i++) {
-        draw_pixel(x1+i, y1 + (gradient * i), colour);
+    return ((unsigned int)r << 11) | ((unsigned int)g << 5) | b;
+}
+
+/*
+ * Lays a see-through colour over a rectangle of the display. The screen
+ * is read back READ_CHUNK pixels at a time, blended and written back, so
+ * no frame buffer is needed.
+ */
+void blend_rectangle(char x1, char y1, char x2, char y2, unsigned int colour, unsigned char alpha) {
+    unsigned int chunk[READ_CHUNK];
+    
+    for(int y = y1; y <= y2; y++) {
+        for(int x = x1; x <= x2; x += READ_CHUNK) {
+            int x_end = x + READ_CHUNK - 1;
+            if(x_end > x2)
+                x_end = x2;
+            
+            read_rectangle(x, y, x_end, y, chunk);
+            
+            set_draw_window(x, y, x_end, y);
+            CSX = 0;
+            LCD_STAT(selects);
+            for(int i = 0; i <= x_end - x; i++) {
+                unsigned int mixed = blend_colour(chunk[i], colour, alpha);
+                spi_write(mixed >> 8);
+                spi_write(mixed & 0xFF);
+            }
+            CSX = 1;
+        }
+    }
+}
+
+#if USE_TEXT
+/*
+ * Checks if a pixel of a character is set, anything outside the 5x7
+ * character counts as empty.
+ */
+char font_pixel(char c, int i, int j) {
+    if(i < 0 || i > 4 || j < 0 || j > 6)
+        return 0;
+    return (font_column(c, i) >> j) & 0x01;
+}
+
+/*
+ * Checks if the empty pixel i, j sits in the inside corner of a diagonal
+ * step towards dx, dy: set pixels beside and above / below it, but not
+ * in the corner between them. (If the corner is set too it is just the
+ * inside of a right angle, like in an L, and is left alone.)
+ */
+char font_step(char c, int i, int j, int dx, int dy) {
+    return font_pixel(c, i+dx, j) && font_pixel(c, i, j+dy) && !font_pixel(c, i+dx, j+dy);
+}
+
+/*
+ * Draws a character with the steps in its diagonal edges softened. Empty
+ * pixels in the inside corner of a step (see font_step()) are blended
+ * half way in to the background.
+ */
+void draw_char_aa(char x, char y, char c, unsigned int colour, char size) {
+    draw_char(x, y, c, colour, size);
+    
+    for(int i = 0; i < 5; i++) {
+        for(int j = 0; j < 7; j++) {
+            if(font_pixel(c, i, j))
+                continue;
+            if(font_step(c, i, j, -1, -1) || font_step(c, i, j, 1, -1)
+                    || font_step(c, i, j, -1, 1) || font_step(c, i, j, 1, 1))
+                blend_rectangle(x+(i*size), y+(j*size), x+(i*size)+size-1, y+(j*size)+size-1, colour, 0x80);
+        }
+    }
+}
+
+/*
+ * Same as draw_string() but with draw_char_aa(). Looks best at size 2
+ * and up.
+ */
+void draw_string_aa(char x, char y, unsigned int colour, char size, char *str) {
+    int char_width = size * 6;
+    int counter = 0;
+    while(str[counter] != '\0') {
+        draw_char_aa(x + (counter * char_width), y, str[counter], colour, size);
+        counter++;
     }
 }
-*/
\ No newline at end of file
+#endif
+#endif
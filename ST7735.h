@@ -10,136 +10,40 @@
 
 #ifdef	__cplusplus
 extern "C" {
+#endif
+
+#include "ST7735_config.h"
+
+#if USE_EXAMPLE_BITMAPS && !USE_BITMAPS
+#error "USE_EXAMPLE_BITMAPS needs USE_BITMAPS"
+#endif
+#if USE_GAUGE && !(USE_LINES && USE_ARCS)
+#error "USE_GAUGE needs USE_LINES and USE_ARCS"
 #endif
 
     /* Font files. Thanks Adafruit!
-     * We (might) have to split out fonts in to two or more
-     * arrays. Most devices have a limit of one RAM bank per
-     * which is probably 256 bytes.
+     * Defined once in ST7735.c as const so that they live in program
+     * memory. They are still split in to two arrays because some devices
+     * can't index a single const table past 256 bytes.
      */
-    const char Font1[] = {
-    0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x5F, 0x00, 0x00,
-    0x00, 0x07, 0x00, 0x07, 0x00,
-    0x14, 0x7F, 0x14, 0x7F, 0x14,
-    0x24, 0x2A, 0x7F, 0x2A, 0x12,
-    0x23, 0x13, 0x08, 0x64, 0x62,
-    0x36, 0x49, 0x56, 0x20, 0x50,
-    0x00, 0x08, 0x07, 0x03, 0x00,
-    0x00, 0x1C, 0x22, 0x41, 0x00,
-    0x00, 0x41, 0x22, 0x1C, 0x00,
-    0x2A, 0x1C, 0x7F, 0x1C, 0x2A,
-    0x08, 0x08, 0x3E, 0x08, 0x08,
-    0x00, 0x80, 0x70, 0x30, 0x00,
-    0x08, 0x08, 0x08, 0x08, 0x08,
-    0x00, 0x00, 0x60, 0x60, 0x00,
-    0x20, 0x10, 0x08, 0x04, 0x02,
-    0x3E, 0x51, 0x49, 0x45, 0x3E,
-    0x00, 0x42, 0x7F, 0x40, 0x00,
-    0x72, 0x49, 0x49, 0x49, 0x46,
-    0x21, 0x41, 0x49, 0x4D, 0x33,
-    0x18, 0x14, 0x12, 0x7F, 0x10,
-    0x27, 0x45, 0x45, 0x45, 0x39,
-    0x3C, 0x4A, 0x49, 0x49, 0x31,
-    0x41, 0x21, 0x11, 0x09, 0x07,
-    0x36, 0x49, 0x49, 0x49, 0x36,
-    0x46, 0x49, 0x49, 0x29, 0x1E,
-    0x00, 0x00, 0x14, 0x00, 0x00,
-    0x00, 0x40, 0x34, 0x00, 0x00,
-    0x00, 0x08, 0x14, 0x22, 0x41,
-    0x14, 0x14, 0x14, 0x14, 0x14,
-    0x00, 0x41, 0x22, 0x14, 0x08,
-    0x02, 0x01, 0x59, 0x09, 0x06,
-    0x3E, 0x41, 0x5D, 0x59, 0x4E,
-    0x7C, 0x12, 0x11, 0x12, 0x7C,
-    0x7F, 0x49, 0x49, 0x49, 0x36,
-    0x3E, 0x41, 0x41, 0x41, 0x22,
-    0x7F, 0x41, 0x41, 0x41, 0x3E,
-    0x7F, 0x49, 0x49, 0x49, 0x41,
-    0x7F, 0x09, 0x09, 0x09, 0x01,
-    0x3E, 0x41, 0x41, 0x51, 0x73,
-    0x7F, 0x08, 0x08, 0x08, 0x7F,
-    0x00, 0x41, 0x7F, 0x41, 0x00,
-    0x20, 0x40, 0x41, 0x3F, 0x01,
-    0x7F, 0x08, 0x14, 0x22, 0x41,
-    0x7F, 0x40, 0x40, 0x40, 0x40,
-    0x7F, 0x02, 0x1C, 0x02, 0x7F,
-    0x7F, 0x04, 0x08, 0x10, 0x7F,
-    0x3E, 0x41, 0x41, 0x41, 0x3E,
-    0x7F, 0x09, 0x09, 0x09, 0x06,
-    0x3E, 0x41, 0x51, 0x21, 0x5E,
-    0x7F, 0x09, 0x19, 0x29, 0x46
-    };
-    const char Font2[] = {
-    0x26, 0x49, 0x49, 0x49, 0x32,
-    0x03, 0x01, 0x7F, 0x01, 0x03,
-    0x3F, 0x40, 0x40, 0x40, 0x3F,
-    0x1F, 0x20, 0x40, 0x20, 0x1F,
-    0x3F, 0x40, 0x38, 0x40, 0x3F,
-    0x63, 0x14, 0x08, 0x14, 0x63,
-    0x03, 0x04, 0x78, 0x04, 0x03,
-    0x61, 0x59, 0x49, 0x4D, 0x43,
-    0x00, 0x7F, 0x41, 0x41, 0x41,
-    0x02, 0x04, 0x08, 0x10, 0x20,
-    0x00, 0x41, 0x41, 0x41, 0x7F,
-    0x04, 0x02, 0x01, 0x02, 0x04,
-    0x40, 0x40, 0x40, 0x40, 0x40,
-    0x00, 0x03, 0x07, 0x08, 0x00,
-    0x20, 0x54, 0x54, 0x78, 0x40,
-    0x7F, 0x28, 0x44, 0x44, 0x38,
-    0x38, 0x44, 0x44, 0x44, 0x28,
-    0x38, 0x44, 0x44, 0x28, 0x7F,
-    0x38, 0x54, 0x54, 0x54, 0x18,
-    0x00, 0x08, 0x7E, 0x09, 0x02,
-    0x18, 0xA4, 0xA4, 0x9C, 0x78,
-    0x7F, 0x08, 0x04, 0x04, 0x78,
-    0x00, 0x44, 0x7D, 0x40, 0x00,
-    0x20, 0x40, 0x40, 0x3D, 0x00,
-    0x7F, 0x10, 0x28, 0x44, 0x00,
-    0x00, 0x41, 0x7F, 0x40, 0x00,
-    0x7C, 0x04, 0x78, 0x04, 0x78,
-    0x7C, 0x08, 0x04, 0x04, 0x78,
-    0x38, 0x44, 0x44, 0x44, 0x38,
-    0xFC, 0x18, 0x24, 0x24, 0x18,
-    0x18, 0x24, 0x24, 0x18, 0xFC,
-    0x7C, 0x08, 0x04, 0x04, 0x08,
-    0x48, 0x54, 0x54, 0x54, 0x24,
-    0x04, 0x04, 0x3F, 0x44, 0x24,
-    0x3C, 0x40, 0x40, 0x20, 0x7C,
-    0x1C, 0x20, 0x40, 0x20, 0x1C,
-    0x3C, 0x40, 0x30, 0x40, 0x3C,
-    0x44, 0x28, 0x10, 0x28, 0x44,
-    0x4C, 0x90, 0x90, 0x90, 0x7C,
-    0x44, 0x64, 0x54, 0x4C, 0x44,
-    0x00, 0x08, 0x36, 0x41, 0x00,
-    0x00, 0x00, 0x77, 0x00, 0x00,
-    0x00, 0x41, 0x36, 0x08, 0x00,
-    0x24, 0x66, 0xE7, 0x66, 0x24
-    };
-    
+#if USE_TEXT
+    extern const char Font1[];
+    extern const char Font2[];
+#endif
+
+#if USE_EXAMPLE_BITMAPS
     //Some bitmaps (see bitmap function for description)
-    //First to integers are width, height respectively.
-    unsigned int testBMP[] = {8, 8,
-        0xAAAA, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x5555,
-        0x0000, 0xAAAA, 0x000F, 0x00F0, 0x0F00, 0xF000, 0x5555, 0x0000,
-        0x0000, 0x0000, 0x00FF, 0x0FF0, 0xFF00, 0xF00F, 0x0000, 0x0000,
-        0x0000, 0x0000, 0x0FFF, 0xFFF0, 0xFF0F, 0xF0FF, 0x0000, 0x0000,
-        0x0000, 0x0000, 0xF0F0, 0x0F0F, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
-        0x0000, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
-        0x0000, 0x5555, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xAAAA, 0x0000,
-        0x5555, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0xAAAA
-    };
-    
-    unsigned int downArrowBMP[] = {8, 4,
-        0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
-        0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000,
-        0x0000, 0x0000, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x0000, 0x0000,
-        0x0000, 0x0000, 0x0000, 0xFFFF, 0xFFFF, 0x0000, 0x0000, 0x0000
-    };
+    extern const unsigned int testBMP[];
+    extern const unsigned int downArrowBMP[];
+#endif
     
     //Command definitions
     #define ST7735_NOP     0x00
     #define ST7735_SWRESET 0x01
+    #define ST7735_SLPIN   0x10
+    #define ST7735_SLPOUT  0x11
+    #define ST7735_PTLON   0x12
+    #define ST7735_NORON   0x13
     #define ST7735_INVOFF  0x20
     #define ST7735_INVON   0x21
     #define ST7735_DISPOFF 0x28
@@ -148,25 +52,78 @@ extern "C" {
     #define ST7735_RASET   0x2B
     #define ST7735_RAMWR   0x2C
     #define ST7735_RAMRD   0x2E
+    #define ST7735_PTLAR   0x30
+    #define ST7735_IDMOFF  0x38
+    #define ST7735_IDMON   0x39
+    #define ST7735_COLMOD  0x3A
+    #define ST7735_FRMCTR1 0xB1
+    #define ST7735_FRMCTR2 0xB2
+    #define ST7735_FRMCTR3 0xB3
+
+#if USE_POWER
+    //Bits in lcd_mode, 0 is normal full screen, full colour
+    #define LCD_MODE_PARTIAL 0x01 //Only the partial area is refreshed
+    #define LCD_MODE_IDLE    0x02 //8 colour mode
+    #define LCD_MODE_SLEEP   0x04 //Panel asleep, nothing shown
+
+    extern unsigned char lcd_mode;
+#endif
+
+#if USE_GAUGE
+    /* A round dial with tick marks and a needle. Fill in everything except
+     * angle, then call gauge_draw() once and gauge_set() for each new value.
+     * Angles are in degrees clockwise from 3 o'clock, e.g. start = 135 and
+     * sweep = 270 gives the usual car dashboard dial.
+     */
+    typedef struct {
+        char cx, cy;            //Centre of the dial
+        char radius;
+        int start;              //Angle of the minimum value
+        int sweep;              //Degrees from minimum to maximum
+        int min, max;           //Value range
+        char ticks;             //Number of ticks, including both ends (2 or more)
+        unsigned int face_colour;
+        unsigned int tick_colour;
+        unsigned int needle_colour;
+        int angle;              //Current needle angle, kept up to date by the driver
+    } gauge_t;
+
+    //Ticks run from 3/4 of the radius to the edge, the needle crosses them
+    #define GAUGE_TICK_IN(r)    ((r) - ((r) >> 2))
+    #define GAUGE_NEEDLE(r)     ((r) - 2)
+#endif
+
+#if USE_BUS_STATS
+    /* Running totals of the SPI traffic sent to the display.
+     * bytes counts every byte on the bus (commands and data), selects
+     * counts the times CSX is pulled low and windows counts calls to
+     * set_draw_window().
+     */
+    typedef struct {
+        unsigned long bytes;
+        unsigned long selects;
+        unsigned long windows;
+#if USE_POWER
+        //Time spent in each power mode, see lcd_stats_tick()
+        unsigned long ms;
+        unsigned long sleep_ms;
+        unsigned long partial_ms;
+        unsigned long idle_ms;
+#endif
+    } lcd_stats_t;
+
+    extern lcd_stats_t lcd_stats;
+
+    #define LCD_STAT(field) lcd_stats.field++
+    void lcd_stats_reset(void);
+    unsigned long lcd_stats_estimate_us(unsigned long spi_khz);
+#if USE_POWER
+    void lcd_stats_tick(unsigned int ms);
+#endif
+#else
+    #define LCD_STAT(field)
+#endif
 
-    //Pin definitions (For PIC18F26K40) - change as required
-    //NOTE: on older micros this will just be RC0, RC1, etc.
-    //On newer chips we have to use the latch registers.
-    #define CSX     LATC0 //Chip select
-    #define RESX    LATC1 //Reset pin
-    #define CMD     LATC2 //Command select
-    //Software SPI pins if required
-    #define SDO     LATC3
-    #define SCK     LATC4
-
-    //Use hardware SPI, will just big bang it through if false
-    #define USE_HW_SPI  1
-    
-    //SPI Bus status register and transmission buffer
-    //Set these to suit your particular microcontroller
-    #define SPIBUF  SPI1TXB
-    #define SPIIDLE SPI1STATUS & 0x20
-    
     void spi_write(unsigned char data);
     void lcd_write_command(unsigned char data);
     void lcd_write_data(unsigned char data);
@@ -174,13 +131,61 @@ extern "C" {
     void delay_ms(double millis);
     void delay_us(long int cycles);
     void lcd_init_command_list(void);
+#if USE_POWER
+    void lcd_sleep(void);
+    void lcd_wake(void);
+    void lcd_partial(char start_row, char end_row);
+    void lcd_normal(void);
+    void lcd_idle(char on);
+    void lcd_frame_rate(unsigned char reg, unsigned char rtna, unsigned char fpa, unsigned char bpa);
+    void lcd_status_strip(char start_row, char end_row);
+    void lcd_full_power(void);
+#endif
     void draw_pixel(char x, char y, unsigned int colour);
     void set_draw_window(char row_start, char row_end, char col_start, char col_end);
+    void set_window_area(char x1, char y1, char x2, char y2);
     void fill_rectangle(char x1, char y1, char x2, char y2, unsigned int colour);
+#if USE_FILLS
+    void fill_gradient(char x1, char y1, char x2, char y2, unsigned int colour_a, unsigned int colour_b, char vertical);
+    void fill_dither(char x1, char y1, char x2, char y2, unsigned int colour_a, unsigned int colour_b, unsigned char level);
+    void fill_pattern(char x1, char y1, char x2, char y2, const unsigned int *tile);
+#endif
+#if USE_TEXT
+    char font_column(char c, char i);
     void draw_char(char x, char y, char c, unsigned int colour, char size);
     void draw_string(char x, char y, unsigned int colour, char size, char *str);
+#endif
+#if USE_BITMAPS
+    void draw_bitmap(int x, int y, int scale, const unsigned int *bmp);
+#endif
+#if USE_LINES
     void draw_line(char x1, char y1, char x2, char y2, unsigned int colour);
-    void draw_bitmap(int x, int y, int scale, unsigned int *bmp);
+#endif
+#if USE_ARCS
+    int sin_fixed(int degrees);
+    int cos_fixed(int degrees);
+    void fill_arc(char cx, char cy, char r_in, char r_out, int start, int end, unsigned int colour);
+    #define fill_annulus(cx, cy, r_in, r_out, colour) fill_arc(cx, cy, r_in, r_out, 0, 360, colour)
+#endif
+#if USE_READBACK
+    unsigned char spi_read(void);
+    void lcd_read_begin(char x1, char y1, char x2, char y2);
+    unsigned int lcd_read_pixel(void);
+    void lcd_read_end(void);
+    void read_rectangle(char x1, char y1, char x2, char y2, unsigned int *buf);
+    void dump_rectangle(char x1, char y1, char x2, char y2, void (*sink)(unsigned int colour));
+    #define dump_screen(sink) dump_rectangle(0, 0, 127, 127, sink)
+    unsigned int blend_colour(unsigned int colour_a, unsigned int colour_b, unsigned char alpha);
+    void blend_rectangle(char x1, char y1, char x2, char y2, unsigned int colour, unsigned char alpha);
+#if USE_TEXT
+    void draw_char_aa(char x, char y, char c, unsigned int colour, char size);
+    void draw_string_aa(char x, char y, unsigned int colour, char size, char *str);
+#endif
+#endif
+#if USE_GAUGE
+    void gauge_draw(gauge_t *g, int value);
+    void gauge_set(gauge_t *g, int value);
+#endif
 
 #ifdef	__cplusplus
 }
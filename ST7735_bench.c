@@ -0,0 +1,160 @@
+/*
+ * File:   ST7735_bench.c
+ * Author: tommy
+ *
+ * Runs a fixed set of drawing workloads and records how much SPI traffic
+ * each one needs, using the counters in lcd_stats. The traffic doesn't
+ * depend on the micro or the bus speed, so the results can be compared
+ * against the stored baselines below to catch changes that make a
+ * primitive more expensive. The bus time is only an estimate from the
+ * byte count (see lcd_stats_estimate_us()).
+ *
+ * Typical use after lcd_init():
+ *     if(bench_run_all(8000))
+ *         LED = 1; //Something got slower
+ *
+ * If you make a primitive cheaper on purpose, update its baseline.
+ */
+
+#include "ST7735_bench.h"
+
+#if USE_BUS_STATS
+
+bench_result_t bench_results[BENCH_COUNT];
+
+/*
+ * Expected traffic for each workload: bytes, CSX selects, windows.
+ * A result above any of these counts as a regression, and so does a
+ * workload that sends nothing at all (it must be broken).
+ */
+const unsigned long bench_baseline[BENCH_COUNT][3] = {
+    {131116, 48, 4}, //BENCH_CLEAR
+    {3328, 3072, 256}, //BENCH_PIXELS
+    {728, 728, 56}, //BENCH_TEXT1
+    {1624, 672, 56}, //BENCH_TEXT2
+    {2408, 672, 56}, //BENCH_TEXT3
+    {3416, 672, 56}, //BENCH_TEXT4
+    {3904, 768, 64}, //BENCH_BITMAP
+    {14662, 10968, 914}, //BENCH_LINES
+    {32812, 48, 4}, //BENCH_FILLS
+    {1219, 1116, 93}, //BENCH_GAUGE
+};
+
+#if USE_BITMAPS
+//8x8 test card for the bitmap workload, first two values are width, height
+const unsigned int bench_bmp[] = {8, 8,
+    0xF800, 0xF800, 0x07E0, 0x07E0, 0x001F, 0x001F, 0xFFFF, 0xFFFF,
+    0xF800, 0xF800, 0x07E0, 0x07E0, 0x001F, 0x001F, 0xFFFF, 0xFFFF,
+    0x07E0, 0x07E0, 0x001F, 0x001F, 0xFFFF, 0xFFFF, 0xF800, 0xF800,
+    0x07E0, 0x07E0, 0x001F, 0x001F, 0xFFFF, 0xFFFF, 0xF800, 0xF800,
+    0x001F, 0x001F, 0xFFFF, 0xFFFF, 0xF800, 0xF800, 0x07E0, 0x07E0,
+    0x001F, 0x001F, 0xFFFF, 0xFFFF, 0xF800, 0xF800, 0x07E0, 0x07E0,
+    0xFFFF, 0xFFFF, 0xF800, 0xF800, 0x07E0, 0x07E0, 0x001F, 0x001F,
+    0xFFFF, 0xFFFF, 0xF800, 0xF800, 0x07E0, 0x07E0, 0x001F, 0x001F
+};
+#endif
+
+#if USE_GAUGE
+//The 60 pixel dial from the README
+gauge_t bench_gauge = {64, 64, 60, 135, 270, 0, 100, 11, 0x0000, 0xFFFF, 0xF800, 0};
+#endif
+
+/*
+ * Runs a single workload and stores its traffic in bench_results[].
+ */
+void bench_run(unsigned char workload, unsigned long spi_khz) {
+    int i, j;
+
+    lcd_stats_reset();
+    bench_results[workload].skipped = 0;
+
+    switch(workload) {
+        case BENCH_CLEAR:
+            //A few full clears in alternating colours
+            for(i = 0; i < 4; i++)
+                fill_rectangle(0, 0, 127, 127, (i & 1) ? 0xFFFF : 0x0000);
+            break;
+        case BENCH_PIXELS:
+            //16x16 grid of single pixels, the worst case for window setup
+            for(i = 0; i < 16; i++) {
+                for(j = 0; j < 16; j++)
+                    fill_rectangle(i * 8, j * 8, i * 8, j * 8, 0xFFFF);
+            }
+            break;
+#if USE_TEXT
+        case BENCH_TEXT1:
+        case BENCH_TEXT2:
+        case BENCH_TEXT3:
+        case BENCH_TEXT4:
+            draw_string(0, 0, 0xFFFF, workload - BENCH_TEXT1 + 1, "Hi 42");
+            break;
+#endif
+#if USE_BITMAPS
+        case BENCH_BITMAP:
+            draw_bitmap(0, 0, 4, bench_bmp);
+            break;
+#endif
+#if USE_LINES
+        case BENCH_LINES:
+            //Fan of lines from the corner, plus one flat and one upright
+            for(i = 0; i < 128; i += 16) {
+                draw_line(0, 0, 127, i, 0xFFFF);
+                draw_line(0, 0, i, 127, 0xFFFF);
+            }
+            draw_line(0, 64, 127, 64, 0xFFFF);
+            draw_line(64, 0, 64, 127, 0xFFFF);
+            break;
+#endif
+#if USE_FILLS && USE_BITMAPS
+        case BENCH_FILLS:
+            //Each of these should only need one draw window
+            fill_gradient(0, 0, 127, 15, 0x001F, 0xF800, 0);
+            fill_gradient(0, 16, 127, 63, 0xFFFF, 0x0000, 1);
+            fill_dither(0, 64, 127, 95, 0x0000, 0xFFFF, 8);
+            fill_pattern(0, 96, 127, 127, bench_bmp);
+            break;
+#endif
+#if USE_GAUGE
+        case BENCH_GAUGE:
+            //First step off the end stop: a diagonal needle crossing a tick.
+            //Only the needle moving is counted, not drawing the dial
+            gauge_draw(&bench_gauge, 0);
+            lcd_stats_reset();
+            gauge_set(&bench_gauge, 1);
+            break;
+#endif
+        default:
+            //Compiled out, there is nothing to measure
+            bench_results[workload].skipped = 1;
+            break;
+    }
+
+    bench_results[workload].bytes = lcd_stats.bytes;
+    bench_results[workload].selects = lcd_stats.selects;
+    bench_results[workload].windows = lcd_stats.windows;
+    bench_results[workload].us = lcd_stats_estimate_us(spi_khz);
+}
+
+/*
+ * Runs every workload at the given SPI clock (kHz) and returns the number
+ * of workloads that regressed (0 = all good). Workloads switched off in
+ * ST7735_config.h are marked as skipped in bench_results[] instead.
+ */
+char bench_run_all(unsigned long spi_khz) {
+    char regressions = 0;
+
+    for(unsigned char i = 0; i < BENCH_COUNT; i++) {
+        bench_run(i, spi_khz);
+        if(bench_results[i].skipped)
+            continue;
+        if(bench_results[i].bytes == 0
+                || bench_results[i].bytes > bench_baseline[i][0]
+                || bench_results[i].selects > bench_baseline[i][1]
+                || bench_results[i].windows > bench_baseline[i][2])
+            regressions++;
+    }
+
+    return regressions;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * File:   ST7735_bench.h
+ * Author: tommy
+ *
+ * Fixed drawing workloads for measuring the SPI cost of each primitive.
+ * Needs USE_BUS_STATS set in ST7735_config.h.
+ */
+
+#ifndef ST7735_BENCH_H
+#define	ST7735_BENCH_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "ST7735.h"
+
+#if USE_BUS_STATS
+
+    //Workload numbers, also the index in to bench_results[]
+    #define BENCH_CLEAR     0 //Full screen clears
+    #define BENCH_PIXELS    1 //Grid of 1 pixel rectangles
+    #define BENCH_TEXT1     2 //String at size 1
+    #define BENCH_TEXT2     3 //String at size 2
+    #define BENCH_TEXT3     4 //String at size 3
+    #define BENCH_TEXT4     5 //String at size 4
+    #define BENCH_BITMAP    6 //Scaled bitmap
+    #define BENCH_LINES     7 //Fan of lines across the screen
+    #define BENCH_FILLS     8 //Gradient title bar, dither and pattern fills
+    #define BENCH_GAUGE     9 //One step of a gauge needle
+    #define BENCH_COUNT     10
+
+    typedef struct {
+        unsigned long bytes;
+        unsigned long selects;
+        unsigned long windows;
+        unsigned long us; //Estimated bus time at the requested SPI clock
+        char skipped;     //Workload compiled out by the feature switches
+    } bench_result_t;
+
+    extern bench_result_t bench_results[BENCH_COUNT];
+
+    void bench_run(unsigned char workload, unsigned long spi_khz);
+    char bench_run_all(unsigned long spi_khz);
+
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ST7735_BENCH_H */
+
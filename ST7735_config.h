@@ -0,0 +1,89 @@
+/*
+ * File:   ST7735_config.h
+ * Author: tommy
+ *
+ * Project specific settings for the ST7735 driver. Change the pins, SPI
+ * registers and feature switches in here rather than in ST7735.h.
+ *
+ * Every feature switch set to 0 is compiled out completely, so turning off
+ * the parts you don't use is the easiest way to fit the driver in to a small
+ * part like the 16F913. "make size" in the host folder prints what each
+ * switch adds, and XC8's memory summary shows the real figures for your part.
+ */
+
+#ifndef ST7735_CONFIG_H
+#define	ST7735_CONFIG_H
+
+    //Pin definitions (For PIC18F26K40) - change as required
+    //NOTE: on older micros this will just be RC0, RC1, etc.
+    //On newer chips we have to use the latch registers.
+    #define CSX     LATC0 //Chip select
+    #define RESX    LATC1 //Reset pin
+    #define CMD     LATC2 //Command select
+    //Software SPI pins if required
+    #define SDO     LATC3
+    #define SCK     LATC4
+
+    //Use hardware SPI, will just big bang it through if 0.
+    //Only the selected SPI routine is compiled in.
+#ifndef USE_HW_SPI
+    #define USE_HW_SPI  1
+#endif
+
+    //SPI Bus status register and transmission buffer
+    //Set these to suit your particular microcontroller
+    #define SPIBUF  SPI1TXB
+    #define SPIIDLE SPI1STATUS & 0x20
+
+    //GRAM readback (USE_READBACK). The display's SDA pin is shared for
+    //both directions, so it is turned around to an input while reading.
+    #define SDA_IN      RC3    //Port (not latch) bit of the SDA pin
+    #define SDA_TRIS    TRISC3 //Direction bit of the SDA pin
+    //Run before / after each read, e.g. to hand SCK and SDA over from
+    //the SPI module to plain I/O pins. Empty if using software SPI.
+    #define SPI_READ_BEGIN()
+    #define SPI_READ_END()
+    #define READ_DUMMY_BITS 8  //Clocks to skip before the first pixel
+    #define READ_CHUNK      16 //Pixels buffered by blend_rectangle() (2 bytes RAM each)
+
+    //Frame rate lcd_init() sets for every mode, and that lcd_full_power()
+    //goes back to (USE_POWER). These are Adafruit's values, see lcd_frame_rate().
+    #define FRAME_RTNA  0x01
+    #define FRAME_FPA   0x2C
+    #define FRAME_BPA   0x2D
+
+    //Feature switches. 1 = compiled in, 0 = compiled out.
+    //Each one can also be set from the command line, e.g. -DUSE_TEXT=0.
+#ifndef USE_TEXT
+    #define USE_TEXT            1 //draw_char(), draw_string() and the font
+#endif
+#ifndef USE_BITMAPS
+    #define USE_BITMAPS         1 //draw_bitmap()
+#endif
+#ifndef USE_EXAMPLE_BITMAPS
+    #define USE_EXAMPLE_BITMAPS 0 //testBMP and downArrowBMP (needs USE_BITMAPS)
+#endif
+#ifndef USE_FILLS
+    #define USE_FILLS           1 //fill_gradient(), fill_dither() and fill_pattern()
+#endif
+#ifndef USE_LINES
+    #define USE_LINES           1 //draw_line()
+#endif
+#ifndef USE_ARCS
+    #define USE_ARCS            1 //sin_fixed(), cos_fixed(), fill_arc() and fill_annulus()
+#endif
+#ifndef USE_GAUGE
+    #define USE_GAUGE           1 //gauge_draw() and gauge_set() (needs USE_LINES and USE_ARCS)
+#endif
+#ifndef USE_POWER
+    #define USE_POWER           1 //Sleep, partial, idle and frame rate control
+#endif
+#ifndef USE_READBACK
+    #define USE_READBACK        0 //Read GRAM back: blending, anti-aliased text, screenshots
+#endif
+#ifndef USE_BUS_STATS
+    #define USE_BUS_STATS       0 //Count SPI traffic in lcd_stats (for ST7735_bench.c)
+#endif
+
+#endif	/* ST7735_CONFIG_H */
+
@@ -0,0 +1,61 @@
+/*
+ * File:   bench_main.c
+ * Author: tommy
+ *
+ * Host benchmark. Runs the ST7735_bench.c workloads against the display
+ * model and prints the traffic and estimated bus time of each one at a
+ * few SPI clocks. Exits with an error if any workload regressed, so
+ * "make bench" fails the build.
+ *
+ * Usage: bench_host [spi_khz ...]   (default 4000 8000 16000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../ST7735_bench.h"
+#include "sim.h"
+
+const char *bench_names[BENCH_COUNT] = {
+    "clear", "pixels", "text1", "text2", "text3", "text4", "bitmap", "lines", "fills", "gauge"
+};
+
+int main(int argc, char *argv[]) {
+    unsigned long default_khz[] = {4000, 8000, 16000};
+    int clocks = argc > 1 ? argc - 1 : 3;
+    int failed = 0;
+
+    sim_reset();
+    lcd_init();
+
+    for(int c = 0; c < clocks; c++) {
+        unsigned long khz = argc > 1 ? strtoul(argv[c + 1], NULL, 10) : default_khz[c];
+        char regressions;
+
+        if(khz == 0) {
+            fprintf(stderr, "bad SPI clock: %s\n", argv[c + 1]);
+            return 2;
+        }
+
+        regressions = bench_run_all(khz);
+        printf("SPI clock %lu kHz\n", khz);
+        printf("%-8s %9s %8s %8s %10s\n", "workload", "bytes", "selects", "windows", "est. us");
+        for(int i = 0; i < BENCH_COUNT; i++) {
+            if(bench_results[i].skipped) {
+                printf("%-8s %9s\n", bench_names[i], "skipped");
+                continue;
+            }
+            printf("%-8s %9lu %8lu %8lu %10lu\n", bench_names[i], bench_results[i].bytes,
+                    bench_results[i].selects, bench_results[i].windows, bench_results[i].us);
+        }
+        printf("%d regression(s)\n\n", regressions);
+        if(regressions)
+            failed = 1;
+    }
+
+    if(sim_errors) {
+        fprintf(stderr, "%u bus protocol error(s)\n", sim_errors);
+        failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,261 @@
+/*
+ * File:   sim.c
+ * Author: tommy
+ *
+ * ST7735 model for host builds, see sim.h.
+ *
+ * Bytes are taken from SPI1TXB each time the driver polls SPI1STATUS,
+ * with CMD (LATC2) telling commands from data. Reads are bit level: the
+ * model counts rising edges on SCK (LATC4) and hands back one bit of
+ * the 18 bit pixel stream per edge, after SIM_READ_DUMMY_BITS dummy
+ * clocks, the same as the panel.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+
+//Registers from xc.h
+unsigned char LATC0 = 1, LATC1 = 1, LATC2 = 1, LATC3;
+unsigned char SPI1TXB;
+
+unsigned int sim_gram[SIM_HEIGHT][SIM_WIDTH];
+sim_panel_t sim_panel;
+sim_time_t sim_time;
+unsigned long sim_spi_khz = 8000;
+unsigned int sim_errors;
+unsigned char sim_sda_tris;
+
+static unsigned char command;
+static int param;
+static int x_start, x_end, y_start, y_end;
+static int x, y;
+static int high_byte = -1;
+static unsigned long long slpin_ns;
+static unsigned char slept; //SLPIN seen since the last reset
+
+//SCK as written by the driver, and the last level the model has seen
+static unsigned char sck = 1, sck_seen = 1;
+static unsigned long read_clocks;
+
+static void error(const char *what) {
+    fprintf(stderr, "sim: %s (command 0x%02X)\n", what, command);
+    sim_errors++;
+}
+
+/*
+ * Moves the model's clock on, adding the time to each active mode.
+ */
+static void advance_ns(unsigned long long ns) {
+    sim_time.total_ns += ns;
+    if(sim_panel.sleep)
+        sim_time.sleep_ns += ns;
+    if(sim_panel.partial)
+        sim_time.partial_ns += ns;
+    if(sim_panel.idle)
+        sim_time.idle_ns += ns;
+}
+
+/*
+ * Power on / SWRESET state. The model doesn't know the real power on
+ * frame rates, so it uses 0xFF to tell them apart from anything the
+ * driver sets.
+ */
+static void panel_reset(void) {
+    sim_panel.sleep = 1;
+    sim_panel.partial = 0;
+    sim_panel.idle = 0;
+    sim_panel.display_on = 0;
+    sim_panel.partial_start = 0;
+    sim_panel.partial_end = SIM_HEIGHT - 1;
+    memset(sim_panel.frmctr, 0xFF, sizeof(sim_panel.frmctr));
+    sim_panel.colmod = 0x06;
+}
+
+void sim_reset(void) {
+    memset(sim_gram, 0, sizeof(sim_gram));
+    memset(&sim_time, 0, sizeof(sim_time));
+    panel_reset();
+    sim_errors = 0;
+    command = 0;
+    param = 0;
+    high_byte = -1;
+    slpin_ns = 0;
+    slept = 0;
+    LATC0 = 1;
+    LATC2 = 1;
+    sck = sck_seen = 1;
+    sim_sda_tris = 0;
+}
+
+void sim_run_ms(unsigned long ms) {
+    advance_ns((unsigned long long)ms * 1000000);
+}
+
+/*
+ * Steps the RAMWR / RAMRD pointer through the window, wrapping at the end.
+ */
+static void next_pixel(void) {
+    if(++x > x_end) {
+        x = x_start;
+        if(++y > y_end)
+            y = y_start;
+    }
+}
+
+static void start_command(unsigned char data) {
+    command = data;
+    param = 0;
+    high_byte = -1;
+
+    switch(command) {
+        case 0x01: //SWRESET
+            panel_reset();
+            break;
+        case 0x10: //SLPIN
+            sim_panel.sleep = 1;
+            slpin_ns = sim_time.total_ns;
+            slept = 1;
+            break;
+        case 0x11: //SLPOUT
+            if(sim_panel.sleep && slept && sim_time.total_ns - slpin_ns < 120000000ULL)
+                error("SLPOUT less than 120ms after SLPIN");
+            sim_panel.sleep = 0;
+            break;
+        case 0x12: //PTLON
+            sim_panel.partial = 1;
+            break;
+        case 0x13: //NORON
+            sim_panel.partial = 0;
+            break;
+        case 0x28: //DISPOFF
+            sim_panel.display_on = 0;
+            break;
+        case 0x29: //DISPON
+            sim_panel.display_on = 1;
+            break;
+        case 0x2C: //RAMWR
+        case 0x2E: //RAMRD
+            x = x_start;
+            y = y_start;
+            read_clocks = 0;
+            break;
+        case 0x38: //IDMOFF
+            sim_panel.idle = 0;
+            break;
+        case 0x39: //IDMON
+            sim_panel.idle = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+static void take_data(unsigned char data) {
+    switch(command) {
+        case 0x2A: //CASET
+        case 0x2B: //RASET
+            if(param == 1 || param == 3) {
+                int *edge = command == 0x2A
+                        ? (param == 1 ? &x_start : &x_end)
+                        : (param == 1 ? &y_start : &y_end);
+                *edge = data;
+            }
+            break;
+        case 0x2C: //RAMWR, 16 bit colour
+            if(high_byte < 0) {
+                high_byte = data;
+            } else {
+                if(x < SIM_WIDTH && y < SIM_HEIGHT)
+                    sim_gram[y][x] = (high_byte << 8) | data;
+                else
+                    error("RAMWR outside GRAM");
+                high_byte = -1;
+                next_pixel();
+            }
+            break;
+        case 0x30: //PTLAR
+            if(param == 1)
+                sim_panel.partial_start = data;
+            if(param == 3)
+                sim_panel.partial_end = data;
+            break;
+        case 0x3A: //COLMOD
+            sim_panel.colmod = data;
+            break;
+        case 0xB1: //FRMCTR1
+        case 0xB2: //FRMCTR2
+        case 0xB3: //FRMCTR3
+            if(param < (command == 0xB3 ? 6 : 3))
+                sim_panel.frmctr[command - 0xB1][param] = data;
+            else
+                error("too many FRMCTR parameters");
+            break;
+        default:
+            break;
+    }
+    param++;
+}
+
+unsigned char sim_spi_status(void) {
+    if(LATC0)
+        error("byte sent with CSX high");
+
+    advance_ns(8000000ULL / sim_spi_khz);
+    if(!LATC2)
+        start_command(SPI1TXB);
+    else
+        take_data(SPI1TXB);
+
+    return 0x20; //Always idle
+}
+
+/*
+ * Catches up with the SCK level the driver last wrote. Every write goes
+ * through sim_sck() first, so no edge is missed.
+ */
+static void sync_sck(void) {
+    if(sck == sck_seen)
+        return;
+    sck_seen = sck;
+    if(sck && command == 0x2E && !LATC0)
+        read_clocks++;
+}
+
+unsigned char *sim_sck(void) {
+    sync_sck();
+    return &sck;
+}
+
+/*
+ * The bit on SDA after the last rising edge. GRAM goes out as 18 bit
+ * colour, one byte per channel with the 6 bits at the top.
+ */
+unsigned char sim_sda_in(void) {
+    sync_sck();
+    if(command != 0x2E || LATC0 || !sim_sda_tris) {
+        error("SDA read outside a RAMRD");
+        return 0;
+    }
+    if(read_clocks <= SIM_READ_DUMMY_BITS)
+        return 1; //Dummy clocks, the line is undefined
+
+    unsigned long bit = read_clocks - SIM_READ_DUMMY_BITS - 1;
+    unsigned long pixel = bit / 24;
+    int channel = (bit / 8) % 3;
+    int width = x_end - x_start + 1;
+    int height = y_end - y_start + 1;
+    int px = x_start + pixel % width;
+    int py = y_start + (pixel / width) % height;
+    unsigned int colour = sim_gram[py][px];
+    unsigned char value;
+
+    if(channel == 0)
+        value = ((colour >> 11) << 1) | (colour >> 15);
+    else if(channel == 1)
+        value = (colour >> 5) & 0x3F;
+    else
+        value = ((colour & 0x1F) << 1) | ((colour >> 4) & 0x01);
+
+    return ((value << 2) >> (7 - bit % 8)) & 0x01;
+}
@@ -0,0 +1,50 @@
+/*
+ * File:   sim.h
+ * Author: tommy
+ *
+ * A simple model of an ST7735 for running the driver on a PC. It decodes
+ * the commands the driver sends, keeps a copy of GRAM, answers RAMRD over
+ * the SDA line and keeps its own clock (bus time plus sim_run_ms()) to
+ * work out how long the panel spent in each power mode.
+ */
+
+#ifndef HOST_SIM_H
+#define	HOST_SIM_H
+
+    //Largest panel the controller can drive
+    #define SIM_WIDTH   132
+    #define SIM_HEIGHT  162
+
+    //Clocks the model sends before the first pixel of a RAMRD
+    #define SIM_READ_DUMMY_BITS 8
+
+    typedef struct {
+        unsigned long long total_ns;
+        unsigned long long sleep_ns;
+        unsigned long long partial_ns;
+        unsigned long long idle_ns;
+    } sim_time_t;
+
+    typedef struct {
+        unsigned char sleep, partial, idle, display_on;
+        unsigned char partial_start, partial_end;
+        unsigned char frmctr[3][6]; //FRMCTR1-3 parameters, FRMCTR3 uses all 6
+        unsigned char colmod;
+    } sim_panel_t;
+
+    extern unsigned int sim_gram[SIM_HEIGHT][SIM_WIDTH];
+    extern sim_panel_t sim_panel;
+    extern sim_time_t sim_time;
+    extern unsigned long sim_spi_khz; //Bus clock used for the model's time
+    extern unsigned int sim_errors;   //Protocol mistakes seen, should stay 0
+    extern unsigned char sim_sda_tris;
+
+    void sim_reset(void);
+    void sim_run_ms(unsigned long ms);
+
+    //Used by xc.h
+    unsigned char *sim_sck(void);
+    unsigned char sim_sda_in(void);
+    unsigned char sim_spi_status(void);
+
+#endif	/* HOST_SIM_H */
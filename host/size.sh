@@ -0,0 +1,72 @@
+#!/bin/sh
+# Builds ST7735.c once with every feature switched off, then once for each
+# feature, and prints the program (text + data) and RAM (data + bss) size
+# of each build and what the feature adds. Features that need others
+# (USE_EXAMPLE_BITMAPS, USE_GAUGE) are built with those on, and what they
+# add is measured against a build with only the ones they need.
+#
+# The numbers come from the host compiler, so they are only a guide to
+# the relative cost of each feature on a PIC. Set CC and SIZE to use a
+# cross compiler instead, e.g. CC=avr-gcc SIZE=avr-size.
+
+CC=${CC:-cc}
+SIZE=${SIZE:-size}
+CFLAGS=${SIZE_CFLAGS:--std=c99 -Os -funsigned-char -Wall -Wextra}
+OBJ=${TMPDIR:-/tmp}/st7735_size_$$.o
+DIR=$(dirname "$0")
+
+SWITCHES="USE_TEXT USE_BITMAPS USE_EXAMPLE_BITMAPS USE_FILLS USE_LINES USE_ARCS USE_GAUGE
+    USE_POWER USE_READBACK USE_BUS_STATS"
+
+# Prints "rom ram" for a build with the switches named in the arguments
+# on and the rest off. Arguments starting with -D are passed as they are.
+measure() {
+    flags=
+    for switch in $SWITCHES; do
+        case " $* " in
+            *" $switch "*) flags="$flags -D$switch=1" ;;
+            *) flags="$flags -D$switch=0" ;;
+        esac
+    done
+    for arg in "$@"; do
+        case $arg in
+            -D*) flags="$flags $arg" ;;
+        esac
+    done
+    $CC $CFLAGS -I"$DIR" $flags -c "$DIR/../ST7735.c" -o "$OBJ" || exit 1
+    $SIZE "$OBJ" | awk 'NR == 2 { print $1 + $2, $2 + $3 }'
+}
+
+set -- $(measure)
+BASE_ROM=$1
+BASE_RAM=$2
+printf '%-20s %8s %8s %8s %8s  %s\n' feature rom ram +rom +ram "measured over"
+printf '%-20s %8s %8s %8s %8s\n' "(nothing)" "$BASE_ROM" "$BASE_RAM" - -
+
+# name:needs:flags, "needs" are the switches the feature depends on and
+# the flags turn on the feature itself
+for row in \
+    "USE_HW_SPI=0::-DUSE_HW_SPI=0" \
+    "USE_TEXT::USE_TEXT" \
+    "USE_BITMAPS::USE_BITMAPS" \
+    "USE_EXAMPLE_BITMAPS:USE_BITMAPS:USE_EXAMPLE_BITMAPS" \
+    "USE_FILLS::USE_FILLS" \
+    "USE_LINES::USE_LINES" \
+    "USE_ARCS::USE_ARCS" \
+    "USE_GAUGE:USE_LINES USE_ARCS:USE_GAUGE" \
+    "USE_POWER::USE_POWER" \
+    "USE_READBACK::USE_READBACK" \
+    "USE_BUS_STATS::USE_BUS_STATS"
+do
+    name=${row%%:*}
+    rest=${row#*:}
+    needs=${rest%%:*}
+    flags=${rest#*:}
+    set -- $(measure $needs)
+    need_rom=$1
+    need_ram=$2
+    set -- $(measure $needs $flags)
+    printf '%-20s %8s %8s %8s %8s  %s\n' "$name" "$1" "$2" $(($1 - need_rom)) $(($2 - need_ram)) "${needs:-(nothing)}"
+done
+
+rm -f "$OBJ"
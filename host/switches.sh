@@ -0,0 +1,41 @@
+#!/bin/sh
+# Compiles ST7735.c and ST7735_bench.c with everything on, then with each
+# feature switch turned off in turn (along with anything that needs it),
+# then with everything off. Warnings are errors, so a switch combination
+# that leaves something undeclared or unused fails the build.
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--std=c99 -O1 -funsigned-char -Wall -Wextra}
+DIR=$(dirname "$0")
+
+SWITCHES="USE_TEXT USE_BITMAPS USE_EXAMPLE_BITMAPS USE_FILLS USE_LINES USE_ARCS USE_GAUGE
+    USE_POWER USE_READBACK USE_BUS_STATS USE_HW_SPI"
+
+# Builds with the switches named in the arguments off and the rest on
+build() {
+    flags=
+    for switch in $SWITCHES; do
+        case " $* " in
+            *" $switch "*) flags="$flags -D$switch=0" ;;
+            *) flags="$flags -D$switch=1" ;;
+        esac
+    done
+    echo "off: ${*:-(nothing)}"
+    for file in ST7735.c ST7735_bench.c; do
+        $CC $CFLAGS -Werror -I"$DIR" $flags -c "$DIR/../$file" -o /dev/null || exit 1
+    done
+}
+
+build
+build USE_TEXT
+build USE_BITMAPS USE_EXAMPLE_BITMAPS
+build USE_EXAMPLE_BITMAPS
+build USE_FILLS
+build USE_LINES USE_GAUGE
+build USE_ARCS USE_GAUGE
+build USE_GAUGE
+build USE_POWER
+build USE_READBACK
+build USE_BUS_STATS
+build USE_HW_SPI
+build $SWITCHES
@@ -0,0 +1,427 @@
+/*
+ * File:   test_main.c
+ * Author: tommy
+ *
+ * Host checks for the driver, run against the display model in sim.c.
+ * Each test starts from a freshly reset model and an initialised driver.
+ * "make test" runs these and then the benchmark.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../ST7735.h"
+#include "sim.h"
+
+//Not in strict C99 <math.h>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int failures;
+
+#define CHECK(cond) do { \
+        if(!(cond)) { \
+            printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while(0)
+
+static void start(void) {
+    sim_reset();
+    lcd_init();
+}
+
+/*
+ * The sine table is sin * 256 rounded, capped at 255 so it fits in a
+ * byte, and the other quadrants and cos_fixed() are folded from it.
+ */
+static void test_sin_fixed(void) {
+    int table = 1, folded = 1;
+
+    for(int d = 0; d < 90; d++) {
+        int expected = (int)lround(sin(d * M_PI / 180) * 256);
+        if(expected > 255)
+            expected = 255;
+        table &= sin_fixed(d) == expected;
+    }
+    CHECK(table);
+    CHECK(sin_fixed(90) == 256);
+
+    for(int d = 0; d < 90; d++) {
+        folded &= sin_fixed(180 - d) == sin_fixed(d);
+        folded &= sin_fixed(180 + d) == -sin_fixed(d);
+        folded &= sin_fixed(360 - d) == -sin_fixed(d);
+        folded &= sin_fixed(d - 360) == sin_fixed(d);
+        folded &= cos_fixed(d) == sin_fixed(90 - d);
+    }
+    CHECK(folded);
+}
+
+/*
+ * Every line lights one pixel per step along its longer axis, from one
+ * end to the other, each within half a pixel of the true line.
+ */
+static int check_line(int x1, int y1, int x2, int y2) {
+    int dx = x2 - x1, dy = y2 - y1;
+    int steep = abs(dy) > abs(dx);
+    int length = steep ? abs(dy) : abs(dx);
+    int lit = 0, ok = 1;
+
+    memset(sim_gram, 0, sizeof(sim_gram));
+    draw_line(x1, y1, x2, y2, 0xFFFF);
+
+    ok &= sim_gram[y1][x1] == 0xFFFF && sim_gram[y2][x2] == 0xFFFF;
+    for(int y = 0; y < 128; y++) {
+        for(int x = 0; x < 128; x++) {
+            if(!sim_gram[y][x])
+                continue;
+            lit++;
+            //How far off the line the pixel is, across the long axis
+            double off = steep
+                    ? x - (x1 + (double)(y - y1) * dx / dy)
+                    : y - (y1 + (double)(x - x1) * dy / (dx ? dx : 1));
+            ok &= fabs(off) <= 0.5 + 1e-9;
+        }
+    }
+    ok &= lit == length + 1;
+    return ok;
+}
+
+static void test_lines(void) {
+    int ok = 1;
+
+    start();
+    //Fans out from the middle and from a corner, in both directions
+    for(int i = 0; i < 128; i += 3) {
+        ok &= check_line(64, 64, i, 0) && check_line(i, 127, 64, 64);
+        ok &= check_line(64, 64, 0, i) && check_line(127, i, 64, 64);
+        ok &= check_line(0, 0, 127, i) && check_line(i, 127, 0, 0);
+    }
+    ok &= check_line(5, 9, 5, 9);
+    CHECK(ok);
+    CHECK(sim_errors == 0);
+}
+
+/*
+ * fill_arc() against a floating point version: inside the ring if the
+ * distance is within r_out + 1/2 and outside r_in - 1/2, and inside the
+ * arc by atan2(). Pixels within a pixel of an edge of the arc are left
+ * out, the fixed point edges are allowed to round either way there.
+ */
+static int check_arc(int r_in, int r_out, int start, int end) {
+    int ok = 1;
+
+    memset(sim_gram, 0, sizeof(sim_gram));
+    fill_arc(64, 64, r_in, r_out, start, end, 0xFFFF);
+
+    for(int y = 0; y < 128; y++) {
+        for(int x = 0; x < 128; x++) {
+            int dx = x - 64, dy = y - 64;
+            int d2 = dx * dx + dy * dy;
+            int inside = d2 <= r_out * r_out + r_out && (!r_in || d2 > r_in * r_in - r_in);
+
+            if(inside && end - start < 360) {
+                double a = atan2(dy, dx) * 180 / M_PI - start;
+                double edge;
+                a -= floor(a / 360) * 360;
+                edge = fmin(fmin(a, 360 - a), fabs(a - (end - start)));
+                if(edge * M_PI / 180 * sqrt(d2) < 1)
+                    continue;
+                inside = a <= end - start;
+            }
+            ok &= (sim_gram[y][x] != 0) == inside;
+        }
+    }
+    return ok;
+}
+
+static void test_arcs(void) {
+    start();
+    CHECK(check_arc(0, 40, 0, 360));
+    CHECK(check_arc(30, 63, 0, 360));
+    CHECK(check_arc(0, 50, 0, 90));
+    CHECK(check_arc(10, 50, 135, 405));
+    CHECK(check_arc(20, 45, -60, 30));
+    CHECK(check_arc(5, 60, 200, 210));
+    CHECK(check_arc(1, 2, 45, 300));
+    CHECK(sim_errors == 0);
+}
+
+/*
+ * After any number of gauge_set() calls the screen is the same as a
+ * gauge drawn from scratch at the last value, so no needle is left
+ * behind and no tick gets rubbed out.
+ */
+static int check_gauge(char radius, int start_angle, int sweep, char ticks) {
+    static unsigned int moved[128][128];
+    static const int values[] = {1, 2, 10, 9, 33, 50, 51, 100, 120, 99, 70, -5, 37, 38, 64};
+    gauge_t g = {64, 64, radius, start_angle, sweep, 0, 100, ticks, 0x0000, 0xFFFF, 0xF800, 0};
+    int same = 1;
+
+    memset(sim_gram, 0, sizeof(sim_gram));
+    gauge_draw(&g, 0);
+    for(int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++)
+        gauge_set(&g, values[i]);
+    for(int y = 0; y < 128; y++)
+        memcpy(moved[y], sim_gram[y], sizeof(moved[y]));
+
+    memset(sim_gram, 0, sizeof(sim_gram));
+    gauge_draw(&g, values[sizeof(values) / sizeof(values[0]) - 1]);
+    for(int y = 0; y < 128; y++)
+        same &= memcmp(moved[y], sim_gram[y], sizeof(moved[y])) == 0;
+    return same;
+}
+
+static void test_gauge_redraw(void) {
+    int ok = 1;
+
+    start();
+    for(char r = 20; r <= 63; r++)
+        ok &= check_gauge(r, 135, 270, 11);
+    CHECK(ok);
+    CHECK(check_gauge(60, 45, -270, 11));
+    CHECK(check_gauge(60, 0, 360, 13));
+    CHECK(check_gauge(40, 180, 180, 2));
+    CHECK(sim_errors == 0);
+}
+
+/*
+ * The status strip profile changes the panel, full power puts it back
+ * exactly as lcd_init() left it, and the model times each mode itself.
+ */
+static void test_power_profiles(void) {
+    sim_panel_t after_init;
+
+    start();
+    after_init = sim_panel;
+    CHECK(!sim_panel.sleep && sim_panel.display_on);
+    CHECK(sim_panel.frmctr[0][0] == FRAME_RTNA && sim_panel.frmctr[0][1] == FRAME_FPA
+            && sim_panel.frmctr[0][2] == FRAME_BPA);
+    CHECK(sim_panel.frmctr[2][3] == FRAME_RTNA && sim_panel.frmctr[2][5] == FRAME_BPA);
+
+    lcd_status_strip(0, 15);
+    CHECK(sim_panel.partial && sim_panel.idle);
+    CHECK(sim_panel.partial_start == 0 && sim_panel.partial_end == 15);
+    CHECK(sim_panel.frmctr[1][0] != FRAME_RTNA);
+    CHECK(lcd_mode == (LCD_MODE_PARTIAL | LCD_MODE_IDLE));
+
+    memset(&sim_time, 0, sizeof(sim_time));
+    sim_run_ms(500);
+    lcd_sleep();
+    sim_run_ms(200);
+    lcd_full_power();
+    CHECK(sim_errors == 0);
+    CHECK(!sim_panel.sleep && !sim_panel.partial && !sim_panel.idle && sim_panel.display_on);
+    CHECK(memcmp(sim_panel.frmctr, after_init.frmctr, sizeof(sim_panel.frmctr)) == 0);
+    CHECK(lcd_mode == 0);
+
+    //Partial and idle for the whole 700ms, asleep for the last 200ms
+    CHECK(sim_time.partial_ns >= 700000000ULL && sim_time.partial_ns < 701000000ULL);
+    CHECK(sim_time.idle_ns >= 700000000ULL && sim_time.idle_ns < 701000000ULL);
+    CHECK(sim_time.sleep_ns >= 200000000ULL && sim_time.sleep_ns < 201000000ULL);
+
+    //Waking up too soon after sleep in is caught by the model
+    printf("  (the next SLPOUT error is expected)\n");
+    lcd_sleep();
+    sim_run_ms(50);
+    lcd_wake();
+    CHECK(sim_errors == 1);
+}
+
+/*
+ * Gradients start and end exactly on their colours, however long they are.
+ */
+static void test_gradient_ends(void) {
+    start();
+
+    fill_gradient(0, 0, 0, 159, 0x0000, 0xFFFF, 1);
+    CHECK(sim_gram[0][0] == 0x0000);
+    CHECK(sim_gram[159][0] == 0xFFFF);
+
+    //Every channel only ever moves towards the end colour
+    int ok = 1;
+    for(int y = 1; y < 160; y++) {
+        unsigned int a = sim_gram[y-1][0], b = sim_gram[y][0];
+        if((b >> 11) < (a >> 11) || ((b >> 5) & 0x3F) < ((a >> 5) & 0x3F) || (b & 0x1F) < (a & 0x1F))
+            ok = 0;
+    }
+    CHECK(ok);
+
+    fill_gradient(1, 0, 127, 0, 0xFFFF, 0x0000, 0);
+    CHECK(sim_gram[0][1] == 0xFFFF);
+    CHECK(sim_gram[0][127] == 0x0000);
+
+    fill_gradient(0, 1, 100, 3, 0xF800, 0x07FF, 0);
+    for(int y = 1; y <= 3; y++) {
+        CHECK(sim_gram[y][0] == 0xF800);
+        CHECK(sim_gram[y][100] == 0x07FF);
+    }
+}
+
+/*
+ * Dither fills next to each other, or redrawn in part, match one big fill.
+ */
+static void test_dither_seams(void) {
+    static unsigned int whole[8][16];
+
+    start();
+    fill_dither(1, 1, 16, 8, 0x0000, 0xFFFF, 7);
+    for(int y = 0; y < 8; y++)
+        memcpy(whole[y], &sim_gram[y + 1][1], sizeof(whole[y]));
+
+    sim_reset();
+    fill_dither(1, 1, 6, 8, 0x0000, 0xFFFF, 7);
+    fill_dither(7, 1, 16, 8, 0x0000, 0xFFFF, 7);
+    fill_dither(3, 2, 9, 5, 0x0000, 0xFFFF, 7);
+    int same = 1;
+    for(int y = 0; y < 8; y++)
+        same &= memcmp(whole[y], &sim_gram[y + 1][1], sizeof(whole[y])) == 0;
+    CHECK(same);
+}
+
+/*
+ * Pattern tiles line up with the screen, not with each fill, so fills
+ * next to each other or redrawn in part match one big fill.
+ */
+static void test_pattern_seams(void) {
+    //Odd sizes so any shift shows up
+    static const unsigned int tile[] = {3, 5,
+        0x0001, 0x0002, 0x0003,
+        0x0004, 0x0005, 0x0006,
+        0x0007, 0x0008, 0x0009,
+        0x000A, 0x000B, 0x000C,
+        0x000D, 0x000E, 0x000F
+    };
+    int aligned = 1;
+
+    start();
+    fill_pattern(2, 1, 20, 12, tile);
+    fill_pattern(21, 1, 40, 12, tile);
+    fill_pattern(2, 13, 40, 30, tile);
+    fill_pattern(7, 4, 11, 17, tile);
+    for(int y = 1; y <= 30; y++)
+        for(int x = 2; x <= 40; x++)
+            aligned &= sim_gram[y][x] == tile[2 + (y % 5) * 3 + x % 3];
+    CHECK(aligned);
+}
+
+/*
+ * RAMRD gives back what was written, through the dummy clocks and the
+ * 18 bit to 5-6-5 packing, a rectangle at a time or the whole screen.
+ */
+static unsigned long dumped;
+static int dump_ok;
+
+static void dump_sink(unsigned int colour) {
+    if(colour != sim_gram[dumped / 128][dumped % 128])
+        dump_ok = 0;
+    dumped++;
+}
+
+static void test_readback(void) {
+    static unsigned int buf[20 * 10];
+
+    start();
+    fill_gradient(0, 0, 127, 127, 0xF81F, 0x07E0, 0);
+    fill_gradient(10, 20, 29, 29, 0x001F, 0xFFE0, 1);
+    draw_pixel(15, 25, 0xA5A5);
+
+    read_rectangle(10, 20, 29, 29, buf);
+    int same = 1;
+    for(int y = 0; y < 10; y++)
+        for(int x = 0; x < 20; x++)
+            same &= buf[y * 20 + x] == sim_gram[y + 20][x + 10];
+    CHECK(same);
+
+    dumped = 0;
+    dump_ok = 1;
+    dump_screen(dump_sink);
+    CHECK(dumped == 128UL * 128);
+    CHECK(dump_ok);
+    CHECK(sim_errors == 0);
+}
+
+/*
+ * Blending only touches its rectangle, half of white over black is mid grey.
+ */
+static void test_blend(void) {
+    start();
+    fill_rectangle(0, 0, 127, 127, 0x0000);
+    blend_rectangle(5, 5, 40, 8, 0xFFFF, 0x80);
+
+    int inside = 1, outside = 1;
+    for(int y = 0; y < 128; y++) {
+        for(int x = 0; x < 128; x++) {
+            if(x >= 5 && x <= 40 && y >= 5 && y <= 8)
+                inside &= sim_gram[y][x] == 0x7BEF;
+            else
+                outside &= sim_gram[y][x] == 0x0000;
+        }
+    }
+    CHECK(inside);
+    CHECK(outside);
+    CHECK(sim_errors == 0);
+}
+
+/*
+ * Counts the pixels of a character cell that are neither text nor
+ * background, after drawing it with draw_char_aa().
+ */
+static int aa_greys(char c, char size) {
+    int greys = 0;
+
+    fill_rectangle(0, 0, 5 * size - 1, 7 * size - 1, 0x0000);
+    draw_char_aa(0, 0, c, 0xFFFF, size);
+    for(int y = 0; y < 7 * size; y++)
+        for(int x = 0; x < 5 * size; x++)
+            if(sim_gram[y][x] != 0x0000 && sim_gram[y][x] != 0xFFFF)
+                greys++;
+    return greys;
+}
+
+/*
+ * Only diagonal steps get softened, square corners are left sharp.
+ */
+static void test_char_aa(void) {
+    start();
+    CHECK(aa_greys('E', 1) == 0);
+    CHECK(aa_greys('L', 1) == 0);
+    CHECK(aa_greys('T', 1) == 0);
+    CHECK(aa_greys('H', 2) == 0);
+    CHECK(aa_greys('V', 1) > 0);
+    CHECK(aa_greys('V', 2) > 0);
+    CHECK(sim_errors == 0);
+}
+
+int main(void) {
+    //Keep the model's error messages in order with ours
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("sine table\n");
+    test_sin_fixed();
+    printf("lines\n");
+    test_lines();
+    printf("arcs\n");
+    test_arcs();
+    printf("gauge redraw\n");
+    test_gauge_redraw();
+    printf("power profiles\n");
+    test_power_profiles();
+    printf("gradient ends\n");
+    test_gradient_ends();
+    printf("dither seams\n");
+    test_dither_seams();
+    printf("pattern seams\n");
+    test_pattern_seams();
+    printf("readback\n");
+    test_readback();
+    printf("blend\n");
+    test_blend();
+    printf("antialiased text\n");
+    test_char_aa();
+
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
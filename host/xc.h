@@ -0,0 +1,28 @@
+/*
+ * File:   xc.h
+ * Author: tommy
+ *
+ * Stand-in for the XC8 device header when building the driver on a PC.
+ * The registers the driver touches are routed to the display model in
+ * sim.c, so ST7735.c builds unchanged with the default pin settings in
+ * ST7735_config.h (hardware SPI on SPI1, pins on port C).
+ */
+
+#ifndef HOST_XC_H
+#define	HOST_XC_H
+
+#include "sim.h"
+
+    //Control pins, plain variables the model reads on each byte
+    extern unsigned char LATC0, LATC1, LATC2, LATC3;
+    //SCK goes through a function so the model can count clock edges
+    #define LATC4       (*sim_sck())
+    #define TRISC3      sim_sda_tris
+    #define RC3         sim_sda_in()
+
+    //Hardware SPI. Writing SPI1TXB just stores the byte, the model takes
+    //it when the driver polls the status register.
+    extern unsigned char SPI1TXB;
+    #define SPI1STATUS  sim_spi_status()
+
+#endif	/* HOST_XC_H */